@@ -27,16 +27,23 @@
 
 // namespace: evt
 
+#include "EVTBasics/EVTAllocator.hpp"
 #include "EVTBasics/EVTAny.hpp"
 #include "EVTBasics/EVTArguments.hpp"
 #include "EVTBasics/EVTArray.hpp" // ~C++17 Recommended
+#include "EVTBasics/EVTAsyncIO.hpp"
+#include "EVTBasics/EVTCompression.hpp"
 #include "EVTBasics/EVTFile.hpp"
+#include "EVTBasics/EVTGrowthPolicy.hpp"
 #include "EVTBasics/EVTOptional.hpp"
 #include "EVTBasics/EVTPointer.hpp"
 #include "EVTBasics/EVTRawPointer.hpp"
 #include "EVTBasics/EVTReadOnly.hpp"
+#include "EVTBasics/EVTSimd.hpp"
 #include "EVTBasics/EVTLazyVar.hpp"
+#include "EVTBasics/EVTLazyView.hpp"
 #include "EVTBasics/EVTRange.hpp"
+#include "EVTBasics/EVTThreadPool.hpp"
 
 #if __cplusplus >= 201406L && defined(__clang__)
 	#include "EVTBasics/EVTPrintC++17.hpp"
@@ -0,0 +1,332 @@
+/*
+ The MIT License (MIT)
+ 
+ Copyright (c) 2017 Daniel Illescas Romero <https://github.com/illescasDaniel>
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <new>
+
+/*
+ Allocators used by RawPointer and Array. An allocator is any copyable class with:
+	
+	void* allocate(std::size_t size, std::size_t alignment);
+	void deallocate(void* memory, std::size_t size, std::size_t alignment) noexcept;
+	void* reallocate(void* memory, std::size_t oldSize, std::size_t newSize, std::size_t alignment); // nullptr if it can't
+
+ reallocate is only used for trivially relocatable elements, so the bytes can be copied.
+
+ Example:
+	
+	evt::MonotonicArena requestArena;
+	evt::Array<int, evt::ArenaAllocator<evt::MonotonicArena>> numbers(requestArena);
+	// ...
+	requestArena.release(); // Once the arrays of the request are gone
+ */
+
+namespace evt {
+	
+	/// Heap memory: malloc/realloc/free, or aligned new for over-aligned types
+	struct DefaultAllocator {
+		
+		static constexpr bool isOverAligned(const std::size_t alignment) noexcept {
+			return alignment > alignof(std::max_align_t);
+		}
+		
+		void* allocate(const std::size_t size, const std::size_t alignment) const {
+			
+			#if defined(__cpp_aligned_new)
+				if (isOverAligned(alignment)) {
+					return ::operator new(size, std::align_val_t(alignment));
+				}
+			#else
+				(void)alignment;
+			#endif
+			
+			void* memory = std::malloc(size > 0 ? size : 1);
+			if (memory == nullptr) { throw std::bad_alloc(); }
+			return memory;
+		}
+		
+		void deallocate(void* memory, const std::size_t, const std::size_t alignment) const noexcept {
+			
+			#if defined(__cpp_aligned_new)
+				if (isOverAligned(alignment)) {
+					::operator delete(memory, std::align_val_t(alignment));
+					return;
+				}
+			#else
+				(void)alignment;
+			#endif
+			
+			std::free(memory);
+		}
+		
+		void* reallocate(void* memory, const std::size_t, const std::size_t newSize, const std::size_t alignment) const {
+			
+			if (isOverAligned(alignment)) {
+				return nullptr;
+			}
+			
+			void* newMemory = std::realloc(memory, newSize > 0 ? newSize : 1);
+			if (newMemory == nullptr) { throw std::bad_alloc(); }
+			return newMemory;
+		}
+	};
+	
+	/// Bump pointer arena. Deallocation is free (only the last allocation is given back),
+	/// and release() drops everything at once. Not thread safe.
+	class MonotonicArena {
+		
+		struct Block {
+			Block* previous;
+			std::size_t size;
+		};
+		
+		Block* currentBlock {nullptr};
+		char* position {nullptr};
+		char* blockEnd {nullptr};
+		char* lastAllocation {nullptr};
+		std::size_t blockSize_;
+		
+		static char* alignedPosition(char* position, const std::size_t alignment) noexcept {
+			const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(position);
+			return position + ((alignment - (address % alignment)) % alignment);
+		}
+		
+		void addBlock(const std::size_t minimumSize) {
+			
+			std::size_t size = sizeof(Block) + minimumSize;
+			if (size < blockSize_) { size = blockSize_; }
+			
+			Block* block = static_cast<Block*>(std::malloc(size));
+			if (block == nullptr) { throw std::bad_alloc(); }
+			
+			block->previous = currentBlock;
+			block->size = size;
+			
+			currentBlock = block;
+			position = reinterpret_cast<char*>(block) + sizeof(Block);
+			blockEnd = reinterpret_cast<char*>(block) + size;
+		}
+		
+		void freeBlocks(Block* block) noexcept {
+			while (block != nullptr) {
+				Block* previous = block->previous;
+				std::free(block);
+				block = previous;
+			}
+		}
+	
+	public:
+		
+		MonotonicArena(const std::size_t blockSize = 64 * 1024): blockSize_(blockSize) {}
+		
+		MonotonicArena(const MonotonicArena&) = delete;
+		MonotonicArena& operator=(const MonotonicArena&) = delete;
+		
+		void* allocate(const std::size_t size, const std::size_t alignment) {
+			
+			char* memory = alignedPosition(position, alignment);
+			
+			if (position == nullptr || memory > blockEnd || size > std::size_t(blockEnd - memory)) {
+				addBlock(size + alignment);
+				memory = alignedPosition(position, alignment);
+			}
+			
+			position = memory + size;
+			lastAllocation = memory;
+			
+			return memory;
+		}
+		
+		void deallocate(void* memory, const std::size_t, const std::size_t) noexcept {
+			if (memory != nullptr && memory == lastAllocation) {
+				position = lastAllocation;
+				lastAllocation = nullptr;
+			}
+		}
+		
+		/// The last allocation grows in place, the others are copied to new memory
+		void* reallocate(void* memory, const std::size_t oldSize, const std::size_t newSize, const std::size_t alignment) {
+			
+			if (memory != nullptr && memory == lastAllocation && newSize <= std::size_t(blockEnd - lastAllocation)) {
+				position = lastAllocation + newSize;
+				return memory;
+			}
+			
+			void* newMemory = this->allocate(newSize, alignment);
+			if (memory != nullptr) {
+				std::memcpy(newMemory, memory, (oldSize < newSize) ? oldSize : newSize);
+			}
+			return newMemory;
+		}
+		
+		/// Frees all the memory of the arena, keeping the last block for reuse.
+		/// Objects allocated here must already be destroyed.
+		void release() noexcept {
+			
+			if (currentBlock == nullptr) { return; }
+			
+			freeBlocks(currentBlock->previous);
+			currentBlock->previous = nullptr;
+			
+			position = reinterpret_cast<char*>(currentBlock) + sizeof(Block);
+			lastAllocation = nullptr;
+		}
+		
+		std::size_t blockSize() const noexcept {
+			return blockSize_;
+		}
+		
+		~MonotonicArena() {
+			freeBlocks(currentBlock);
+		}
+	};
+	
+	/// Free lists for power of two size classes (16 bytes to 64KiB), bigger or over-aligned
+	/// allocations go to the heap. Memory of the classes is taken from a MonotonicArena. Not thread safe.
+	class SizeClassPool {
+		
+		static constexpr std::size_t minimumClassSize = 16;
+		static constexpr std::size_t numberOfClasses = 13;
+		static constexpr std::size_t maximumClassSize = minimumClassSize << (numberOfClasses - 1);
+		
+		struct FreeNode {
+			FreeNode* next;
+		};
+		
+		FreeNode* freeLists[numberOfClasses] {};
+		MonotonicArena chunks;
+		
+		static bool isPooled(const std::size_t size, const std::size_t alignment) noexcept {
+			return size <= maximumClassSize && alignment <= alignof(std::max_align_t);
+		}
+		
+		static std::size_t classIndex(const std::size_t size) noexcept {
+			std::size_t index = 0;
+			while ((minimumClassSize << index) < size) {
+				index += 1;
+			}
+			return index;
+		}
+	
+	public:
+		
+		SizeClassPool(const std::size_t chunkSize = 256 * 1024): chunks(chunkSize) {}
+		
+		SizeClassPool(const SizeClassPool&) = delete;
+		SizeClassPool& operator=(const SizeClassPool&) = delete;
+		
+		void* allocate(const std::size_t size, const std::size_t alignment) {
+			
+			if (!isPooled(size, alignment)) {
+				return DefaultAllocator().allocate(size, alignment);
+			}
+			
+			const std::size_t index = classIndex(size);
+			
+			if (FreeNode* node = freeLists[index]) {
+				freeLists[index] = node->next;
+				return node;
+			}
+			
+			return chunks.allocate(minimumClassSize << index, alignof(std::max_align_t));
+		}
+		
+		void deallocate(void* memory, const std::size_t size, const std::size_t alignment) noexcept {
+			
+			if (memory == nullptr) { return; }
+			
+			if (!isPooled(size, alignment)) {
+				DefaultAllocator().deallocate(memory, size, alignment);
+				return;
+			}
+			
+			const std::size_t index = classIndex(size);
+			FreeNode* node = static_cast<FreeNode*>(memory);
+			node->next = freeLists[index];
+			freeLists[index] = node;
+		}
+		
+		void* reallocate(void* memory, const std::size_t oldSize, const std::size_t newSize, const std::size_t alignment) {
+			
+			const bool wasPooled = isPooled(oldSize, alignment);
+			const bool willBePooled = isPooled(newSize, alignment);
+			
+			if (!wasPooled && !willBePooled) {
+				return DefaultAllocator().reallocate(memory, oldSize, newSize, alignment);
+			}
+			if (wasPooled && willBePooled && classIndex(oldSize) == classIndex(newSize)) {
+				return memory;
+			}
+			
+			void* newMemory = this->allocate(newSize, alignment);
+			std::memcpy(newMemory, memory, (oldSize < newSize) ? oldSize : newSize);
+			this->deallocate(memory, oldSize, alignment);
+			
+			return newMemory;
+		}
+		
+		/// Frees all the pooled memory at once. Objects allocated here must already be destroyed
+		/// (allocations that went to the heap are still owned by their objects).
+		void release() noexcept {
+			for (auto& freeList: freeLists) {
+				freeList = nullptr;
+			}
+			chunks.release();
+		}
+	};
+	
+	/// Lightweight allocator that uses a MonotonicArena or SizeClassPool owned by someone else.
+	/// Without a resource it uses the heap.
+	template <typename Resource>
+	class ArenaAllocator {
+		
+		Resource* resource_ {nullptr};
+	
+	public:
+		
+		ArenaAllocator() noexcept {}
+		ArenaAllocator(Resource& resource) noexcept: resource_(&resource) {}
+		
+		void* allocate(const std::size_t size, const std::size_t alignment) const {
+			return resource_ ? resource_->allocate(size, alignment) : DefaultAllocator().allocate(size, alignment);
+		}
+		
+		void deallocate(void* memory, const std::size_t size, const std::size_t alignment) const noexcept {
+			resource_ ? resource_->deallocate(memory, size, alignment) : DefaultAllocator().deallocate(memory, size, alignment);
+		}
+		
+		void* reallocate(void* memory, const std::size_t oldSize, const std::size_t newSize, const std::size_t alignment) const {
+			return resource_ ? resource_->reallocate(memory, oldSize, newSize, alignment) : DefaultAllocator().reallocate(memory, oldSize, newSize, alignment);
+		}
+		
+		Resource* resource() const noexcept {
+			return resource_;
+		}
+	};
+}
@@ -24,8 +24,12 @@
 
 #pragma once
 
-#include <memory>
 #include <stdexcept>
+#include <string>
+#include <new>
+#include <typeinfo>
+#include <type_traits>
+#include <utility>
 
 #if (__cplusplus > 201103L)
 #define CONSTEXPR constexpr
@@ -33,51 +37,250 @@
 #define CONSTEXPR
 #endif
 
+/*
+ Holds a value of any copyable type. Values up to 4 pointers big (like std::string with libstdc++) are stored
+ inside the Any, bigger ones in the heap. Copying an Any copies its value.
+
+ Example:
+	
+	evt::Array<evt::Any> record {"name", 10, 5.1};
+	
+	if (record[1].is<int>()) {
+		int& age = record[1].uncheckedAs<int>();
+	}
+	double ratio = record[2].as<double>(); // Throws std::bad_cast if it isn't a double
+ */
+
 namespace evt {
 	
+	namespace internalEVT {
+		
+		/// Type stored for a value given to an Any, C strings are stored as std::string
+		template <typename Value, typename Decayed = typename std::decay<Value>::type>
+		struct AnyValueType { typedef Decayed type; };
+		
+		template <typename Value>
+		struct AnyValueType<Value, const char*> { typedef std::string type; };
+		
+		template <typename Value>
+		struct AnyValueType<Value, char*> { typedef std::string type; };
+	}
+	
 	class Any {
 		
-		std::shared_ptr<void*> value_ { nullptr };
+		static constexpr std::size_t inlineSize = 4 * sizeof(void*);
+		
+		union Storage {
+			void* pointer;
+			double alignment;
+			unsigned char bytes[inlineSize];
+		};
+		
+		/// What an Any needs to know about the type of its value, one static instance per type
+		struct Operations {
+			const std::type_info* type;
+			void (*copy)(const Any& from, Any& to);
+			void (*move)(Any& from, Any& to);
+			void (*destroy)(Any& any);
+		};
+		
+		template <typename Type>
+		struct fitsInline {
+			static constexpr bool value = sizeof(Type) <= inlineSize && alignof(Type) <= alignof(Storage) && std::is_nothrow_move_constructible<Type>::value;
+		};
+		
+		template <typename Type, bool IsInline = fitsInline<Type>::value>
+		struct Handler;
+		
+		template <typename Type>
+		struct Handler<Type, true> {
+			
+			template <typename... Arguments>
+			static void create(Any& any, Arguments&&... arguments) {
+				::new (static_cast<void*>(any.storage_.bytes)) Type(std::forward<Arguments>(arguments)...);
+			}
+			
+			static Type* pointer(const Any& any) noexcept {
+				return reinterpret_cast<Type*>(const_cast<unsigned char*>(any.storage_.bytes));
+			}
+			
+			static void move(Any& from, Any& to) {
+				create(to, std::move(*pointer(from)));
+				destroy(from);
+			}
+			
+			static void destroy(Any& any) {
+				pointer(any)->~Type();
+			}
+		};
 		
+		template <typename Type>
+		struct Handler<Type, false> {
+			
+			template <typename... Arguments>
+			static void create(Any& any, Arguments&&... arguments) {
+				any.storage_.pointer = new Type(std::forward<Arguments>(arguments)...);
+			}
+			
+			static Type* pointer(const Any& any) noexcept {
+				return static_cast<Type*>(any.storage_.pointer);
+			}
+			
+			static void move(Any& from, Any& to) {
+				to.storage_.pointer = from.storage_.pointer;
+			}
+			
+			static void destroy(Any& any) {
+				delete pointer(any);
+			}
+		};
+		
+		template <typename Type>
+		static void copyValue(const Any& from, Any& to) {
+			Handler<Type>::create(to, *Handler<Type>::pointer(from));
+		}
+		
+		template <typename Type>
+		static const Operations* operationsFor() noexcept {
+			static const Operations operations {&typeid(Type), &copyValue<Type>, &Handler<Type>::move, &Handler<Type>::destroy};
+			return &operations;
+		}
+		
+		template <typename Value>
+		using IfNotAny = typename std::enable_if<!std::is_same<typename std::decay<Value>::type, Any>::value>::type;
+		
+		template <typename Value>
+		using ValueType = typename internalEVT::AnyValueType<Value>::type;
+		
+		/// How a value is stored doesn't depend on const/volatile, so as<const Type>() finds a stored Type
+		template <typename Type>
+		using StoredType = typename std::remove_cv<Type>::type;
+		
+		Storage storage_;
+		const Operations* operations_ {nullptr};
+		
+		template <typename Type>
+		void checkType() const {
+			if (operations_ == nullptr) { throw std::bad_alloc(); }
+			if (!this->is<Type>()) { throw std::bad_cast(); }
+		}
+	
 	public:
 		
-		Any() {}
+		Any() noexcept {}
 		
-		template<typename Type>
-		Any(const Type& value) {
-			this->value_ = std::make_shared<void*>(new Type{value});
+		template <typename Value, typename = IfNotAny<Value>>
+		Any(Value&& value) {
+			this->emplace<ValueType<Value>>(std::forward<Value>(value));
 		}
 		
-		Any(const char* value) {
-			this->value_ = std::make_shared<void*>(new std::string{value});
+		Any(const Any& other) {
+			if (other.operations_ != nullptr) {
+				other.operations_->copy(other, *this);
+				operations_ = other.operations_;
+			}
 		}
 		
-		template<typename Type>
-		CONSTEXPR Type& as() const {
-			if (value_ == nullptr) { throw std::bad_alloc(); }
-			return *static_cast<Type*>(*this->value_);
+		Any(Any&& other) noexcept {
+			if (other.operations_ != nullptr) {
+				other.operations_->move(other, *this);
+				operations_ = other.operations_;
+				other.operations_ = nullptr;
+			}
+		}
+		
+		Any& operator=(const Any& other) {
+			if (this != &other) {
+				Any copy(other);
+				*this = std::move(copy);
+			}
+			return *this;
+		}
+		
+		Any& operator=(Any&& other) noexcept {
+			if (this != &other) {
+				this->reset();
+				if (other.operations_ != nullptr) {
+					other.operations_->move(other, *this);
+					operations_ = other.operations_;
+					other.operations_ = nullptr;
+				}
+			}
+			return *this;
+		}
+		
+		/// The value is built before destroying the current one, so it can come from it
+		template <typename Value, typename = IfNotAny<Value>>
+		ValueType<Value>& operator=(Value&& newValue) {
+			*this = Any(std::forward<Value>(newValue));
+			return this->uncheckedAs<ValueType<Value>>();
+		}
+		
+		~Any() {
+			this->reset();
+		}
+		
+		/// Replaces the value with a new one built from the arguments
+		template <typename Type, typename... Arguments>
+		Type& emplace(Arguments&&... arguments) {
+			this->reset();
+			Handler<StoredType<Type>>::create(*this, std::forward<Arguments>(arguments)...);
+			operations_ = operationsFor<StoredType<Type>>();
+			return this->uncheckedAs<Type>();
+		}
+		
+		void reset() noexcept {
+			if (operations_ != nullptr) {
+				operations_->destroy(*this);
+				operations_ = nullptr;
+			}
+		}
+		
+		CONSTEXPR bool isNull() const noexcept {
+			return operations_ == nullptr;
+		}
+		
+		CONSTEXPR bool isNotNull() const noexcept {
+			return operations_ != nullptr;
+		}
+		
+		/// Type of the value, typeid(void) if there is none
+		const std::type_info& type() const noexcept {
+			return (operations_ != nullptr) ? *operations_->type : typeid(void);
 		}
 		
 		template <typename Type>
-		CONSTEXPR operator Type() const {
-			return this->as<Type>();
+		bool is() const noexcept {
+			return operations_ != nullptr && (operations_ == operationsFor<StoredType<Type>>() || *operations_->type == typeid(Type));
 		}
 		
-		std::string operator=(const char* newValue) {
-			value_ = std::make_shared<void*>(new std::string{newValue});
-			return static_cast<std::string>(std::string(newValue));
+		/// Throws std::bad_cast if the value isn't a Type (std::bad_alloc if there is no value)
+		template <typename Type>
+		Type& as() {
+			this->checkType<Type>();
+			return this->uncheckedAs<Type>();
 		}
 		
-		template<typename Type>
-		CONSTEXPR Type& operator=(const Type& newValue) {
-			value_ = std::make_shared<void*>(new Type{newValue});
-			return *reinterpret_cast<Type*>(*value_);
+		template <typename Type>
+		const Type& as() const {
+			this->checkType<Type>();
+			return this->uncheckedAs<Type>();
 		}
 		
-		template<typename Type>
-		CONSTEXPR Any& operator=(const Any& newValue) {
-			value_ = std::move(newValue.value_);
-			return *this;
+		/// Without checking the type, the value must be a Type
+		template <typename Type>
+		Type& uncheckedAs() noexcept {
+			return *Handler<StoredType<Type>>::pointer(*this);
+		}
+		
+		template <typename Type>
+		const Type& uncheckedAs() const noexcept {
+			return *Handler<StoredType<Type>>::pointer(*this);
+		}
+		
+		template <typename Type>
+		operator Type() const {
+			return this->as<Type>();
 		}
 	};
 }
@@ -31,9 +31,14 @@
 #include <memory>
 #include <random>
 #include <functional>
-#include <thread>
+#include <atomic>
+#include <cstring>
 #include "EVTOptional.hpp"
 #include "EVTRawPointer.hpp"
+#include "EVTGrowthPolicy.hpp"
+#include "EVTThreadPool.hpp"
+#include "EVTLazyView.hpp"
+#include "EVTSimd.hpp"
 #include "EVTRange.hpp"
 #include "../EVTProtocols.hpp"
 
@@ -63,73 +68,204 @@ namespace evt {
 		/* Place your custom "to_string()" function/s here for other classes, or just inherit from EVTObject. */
 	}
 	
+	namespace internalEVT {
+		
+		/// Memory for the first elements of an array, inside the array object itself
+		template <typename Type, std::size_t Capacity>
+		class InlineStorage {
+			alignas(Type) unsigned char bytes[Capacity * sizeof(Type)];
+		protected:
+			Type* inlineData() noexcept { return reinterpret_cast<Type*>(bytes); }
+		};
+		
+		template <typename Type>
+		class InlineStorage<Type, 0> {
+		protected:
+			Type* inlineData() noexcept { return nullptr; }
+		};
+		
+		template <typename...>
+		struct voidType { typedef void type; };
+		
+		template <typename Function, typename... Arguments>
+		using CallResult = decltype(std::declval<const Function&>()(std::declval<Arguments>()...));
+		
+		/// Function can be called like Signature (with any result if Signature returns void)
+		template <typename Function, typename Signature, typename = void>
+		struct isCallableAs: std::false_type {};
+		
+		template <typename Function, typename Result, typename... Arguments>
+		struct isCallableAs<Function, Result(Arguments...), typename voidType<CallResult<Function, Arguments...>>::type>:
+			std::integral_constant<bool, std::is_void<Result>::value || std::is_convertible<CallResult<Function, Arguments...>, Result>::value> {};
+		
+		template <typename Function, typename Signature>
+		using IfCallableAs = typename std::enable_if<isCallableAs<Function, Signature>::value>::type;
+		
+		/// Element type of a mapped array: MapType, or the result of Function if MapType is void
+		template <typename MapType, typename Function, typename Argument>
+		using MapResult = typename std::conditional<std::is_void<MapType>::value, typename std::decay<CallResult<Function, Argument>>::type, MapType>::type;
+	}
+	
 	// MARK: - Array Class
-	template <typename Type>
-	class Array {
+	
+	/// InlineCapacity elements are stored inside the array object, the heap is only used beyond that (see SmallArray).
+	/// GrowthPolicy chooses the capacity when growing and shrinking (see EVTGrowthPolicy.hpp)
+	template <typename Type, typename Allocator = evt::DefaultAllocator, std::size_t InlineCapacity = 0, typename GrowthPolicy = evt::DefaultGrowth>
+	class Array: private internalEVT::InlineStorage<Type, InlineCapacity> {
 		
 		// Types and macros
 		typedef std::size_t SizeType;
-		typedef evt::RawPointer<Type[]> Pointer;
+		typedef evt::RawPointer<Type[], Allocator> Pointer;
 		typedef std::initializer_list<Type> InitializerList;
 		
+		static constexpr bool relocatesWithMemcpy = evt::isTriviallyRelocatable<Type>::value;
+		
+		/// Moving an array only moves its elements one by one when they are in the inline storage
+		static constexpr bool isNothrowMovable = (InlineCapacity == 0) || relocatesWithMemcpy || std::is_nothrow_move_constructible<Type>::value;
+		
+		/// Minimum elements per chunk of the parallel functions, about half of a L1 cache
+		static constexpr SizeType elementsPerParallelChunk = (sizeof(Type) < 16 * 1024) ? (16 * 1024 / sizeof(Type)) : 1;
+		
+		template <typename, typename, std::size_t, typename> friend class Array;
+		
 		// MARK: - Attributes
 		
-		Pointer values;
+		// Elements in [0, count_) are alive, the rest of the memory is uninitialized (an empty array has no memory until it needs it)
+		Pointer values = initialValues(0, Allocator());
 		SizeType count_ {0};
 		
 		// MARK: - Private Functions
 		
-		/// Assigns new memory, also updates the new capacity.
-		CONSTEXPR void assignMemoryAndCapacityForSize(SizeType newSize, bool forceResize = false) {
-			if (forceResize or values.capacity() < newSize) {
-				values = std::move(Pointer(newSize));
+		/// Memory for a new array, the inline storage is used if the capacity fits in it
+		Pointer initialValues(const SizeType capacity, const Allocator& allocator) {
+			if (InlineCapacity > 0 && capacity <= InlineCapacity) {
+				return Pointer(this->inlineData(), InlineCapacity, evt::uninitialized, allocator);
+			}
+			return Pointer(capacity, evt::uninitialized, allocator);
+		}
+		
+		CONSTEXPR bool isUsingInlineValues() const {
+			return InlineCapacity > 0 && values.data() == const_cast<Array*>(this)->inlineData();
+		}
+		
+		/// New memory that can be used while the current one is still alive
+		Pointer allocateValues(const SizeType capacity) {
+			if (this->isUsingInlineValues()) {
+				return Pointer(capacity, evt::uninitialized, values.allocator());
+			}
+			return initialValues(capacity, values.allocator());
+		}
+		
+		/// Replaces the memory of an array without alive elements, the inline storage is kept if possible
+		CONSTEXPR void replaceEmptyValues(const SizeType capacity) {
+			if (!(this->isUsingInlineValues() && capacity <= InlineCapacity)) {
+				values = allocateValues(capacity);
 			}
 		}
 		
-		/// Resizes the array to a given size
-		CONSTEXPR void resizeValuesToSize(const SizeType newSize, bool move = 0) {
+		/// Capacity for at least minimumCapacity elements, a capacityResizeFactor of 0 uses the growth policy.
+		/// Growing for one more element must ask for count_ + 1, a factor of 1 doesn't grow by itself
+		CONSTEXPR SizeType grownCapacity(const SizeType capacityResizeFactor, const SizeType minimumCapacity = 0) const {
 			
-			Pointer newValues (newSize);
+			if (capacityResizeFactor == 0) {
+				return GrowthPolicy::grownCapacity(values.capacity(), minimumCapacity, sizeof(Type));
+			}
 			
-			move ? newValues.moveValuesFrom(values) : newValues.copyValuesFrom(values);
+			const SizeType newCapacity = (values.capacity() > 0) ? (values.capacity() * capacityResizeFactor) : 1;
+			return (newCapacity > minimumCapacity) ? newCapacity : minimumCapacity;
+		}
+		
+		/// Destroys the alive elements from a given position, the capacity isn't affected
+		CONSTEXPR void truncateToCount(const SizeType newCount) {
+			if (newCount < count_) {
+				values.destroyRange(newCount, count_);
+				count_ = newCount;
+			}
+		}
+		
+		/// Moves the alive elements to new memory (which may already contain other constructed elements after count_)
+		CONSTEXPR void relocateValuesTo(Pointer& newValues) {
+			if (relocatesWithMemcpy) {
+				if (count_ > 0) {
+					std::memcpy(static_cast<void*>(newValues.data()), static_cast<const void*>(this->begin()), count_ * sizeof(Type));
+				}
+			} else {
+				std::uninitialized_copy(std::make_move_iterator(this->begin()), std::make_move_iterator(this->end()), newValues.data());
+				values.destroyRange(0, count_);
+			}
 			values = std::move(newValues);
 		}
 		
-		template <typename MagicContainer>
-		CONSTEXPR void assignNewMagicElements(MagicContainer&& elements, const std::size_t initialCapacity = 2) {
-			count_ = std::distance(std::begin(elements), std::end(elements));
-			assignMemoryAndCapacityForSize((count_ > initialCapacity) ? count_ : initialCapacity);
-			assignNewElements(std::forward<MagicContainer>(elements));
+		/// Shifts [index, count_) one position to the right, leaving the index position without an alive element
+		CONSTEXPR void relocateValuesOneRight(const SizeType index) {
+			std::memmove(static_cast<void*>(this->begin() + index + 1), static_cast<const void*>(this->begin() + index), (count_ - index) * sizeof(Type));
 		}
-		/// Replaces the content of the array with other elements
-		template <typename Container>
-		CONSTEXPR void assignNewElements(const Container& elements) {
-			values.copyValuesFrom(elements);
+		
+		/// Resizes the array memory to a given capacity, which must be >= count
+		CONSTEXPR void resizeValuesToSize(const SizeType newSize) {
+			
+			if (newSize <= InlineCapacity) {
+				if (this->isUsingInlineValues()) {
+					return;
+				}
+			}
+			else if (relocatesWithMemcpy && values.reallocate(newSize)) {
+				return;
+			}
+			
+			Pointer newValues = allocateValues(newSize);
+			relocateValuesTo(newValues);
 		}
 		
-		template <typename Container>
-		CONSTEXPR void assignNewElements(Container&& elements) {
-			values.moveValuesFrom(std::move(elements));
+		/// Grows the memory and constructs a new last element, which may come from this same array
+		template <typename Value>
+		CONSTEXPR void growAndAppend(Value&& newElement, const SizeType capacityResizeFactor) {
+			
+			if (relocatesWithMemcpy) {
+				Type element(std::forward<Value>(newElement));
+				resizeValuesToSize(grownCapacity(capacityResizeFactor, count_ + 1));
+				values.constructAt(count_, std::move(element));
+				return;
+			}
+			
+			// The new element is built before moving the others
+			Pointer newValues = allocateValues(grownCapacity(capacityResizeFactor, count_ + 1));
+			newValues.constructAt(count_, std::forward<Value>(newElement));
+			relocateValuesTo(newValues);
 		}
 		
-		template <typename Container>
-		Array& appendNewElements(const Container& newElements) {
+		/// Replaces the content of the array with other elements
+		template <typename Iterator>
+		CONSTEXPR void assignNewElements(Iterator first, Iterator last, const SizeType initialCapacity = 2) {
 			
-			SizeType countOfContainer = std::distance(std::begin(newElements), std::end(newElements));
+			truncateToCount(0);
+			
+			const SizeType newCount = std::distance(first, last);
+			const SizeType newCapacity = (newCount > initialCapacity) ? newCount : initialCapacity;
+			
+			if (values.capacity() != newCapacity) {
+				replaceEmptyValues(newCapacity);
+			}
+			
+			std::uninitialized_copy(first, last, values.data());
+			count_ = newCount;
+		}
+		
+		template <typename Iterator>
+		Array& appendNewElements(Iterator first, Iterator last) {
+			
+			SizeType countOfContainer = std::distance(first, last);
 			
 			if (values.capacity() >= (count_ + countOfContainer)) {
-				values.copyValuesFrom(newElements, count_);
+				std::uninitialized_copy(first, last, this->end());
 			}
 			else if (countOfContainer > 0) {
 				
-				SizeType newCapacity = countOfContainer + count_;
-				
-				Pointer newValues (newCapacity);
+				Pointer newValues = allocateValues(grownCapacity(0, count_ + countOfContainer));
 				
-				std::copy(&values[0], &values[count_], &newValues[0]);
-				newValues.copyValuesFrom(newElements, count_);
-				
-				values = std::move(newValues);
+				// New elements are built first, in case they come from this same array
+				std::uninitialized_copy(first, last, newValues.data() + count_);
+				relocateValuesTo(newValues);
 			}
 			
 			count_ += countOfContainer;
@@ -137,65 +273,127 @@ namespace evt {
 			return *this;
 		}
 		
+		template <typename Container>
+		Array& appendNewElements(const Container& newElements) {
+			return appendNewElements(std::begin(newElements), std::end(newElements));
+		}
+		
 		template <typename Container>
 		Array& appendNewElementsMOVE(Container&& newElements) {
+			// Lvalues also bind here (forwarding reference), those must be copied
+			if (std::is_lvalue_reference<Container>::value) {
+				return appendNewElements(std::begin(newElements), std::end(newElements));
+			}
+			return appendNewElements(std::make_move_iterator(std::begin(newElements)), std::make_move_iterator(std::end(newElements)));
+		}
+		
+		/// Removes every ocurrence of the sequence newElements (or the first one) in a single pass.
+		/// The kept elements are compacted while a KMP matcher looks for the sequence at their end,
+		/// so ocurrences that appear after a removal are also removed
+		template <typename Container>
+		Array& removeElementsFromContainer(const Container& newElements, bool onlyFirstOcurrence = false) {
 			
-			SizeType countOfContainer = std::distance(std::begin(newElements), std::end(newElements));
+			typedef typename std::remove_reference<decltype(*std::begin(newElements))>::type PatternElement;
 			
-			if (values.capacity() >= (count_ + countOfContainer)) {
-				values.moveValuesFrom(newElements, count_);
+			const SizeType patternCount = std::distance(std::begin(newElements), std::end(newElements));
+			if (patternCount == 0 || patternCount > count_) { return *this; }
+			
+			std::unique_ptr<const PatternElement*[]> pattern(new const PatternElement*[patternCount]);
+			std::unique_ptr<SizeType[]> fallback(new SizeType[patternCount]);
+			std::unique_ptr<SizeType[]> matchedCountAt(new SizeType[count_]);
+			
+			SizeType index = 0;
+			for (const auto& newElement: newElements) {
+				pattern[index++] = &newElement;
 			}
-			else if (countOfContainer > 0) {
+			
+			fallback[0] = 0;
+			for (SizeType i = 1; i < patternCount; ++i) {
+				SizeType matchedCount = fallback[i-1];
+				while (matchedCount > 0 && !(*pattern[i] == *pattern[matchedCount])) {
+					matchedCount = fallback[matchedCount-1];
+				}
+				fallback[i] = (*pattern[i] == *pattern[matchedCount]) ? (matchedCount + 1) : 0;
+			}
+			
+			SizeType keptCount = 0;
+			SizeType matchedCount = 0;
+			bool isSearching = true;
+			
+			for (SizeType readIndex = 0; readIndex < count_; ++readIndex) {
 				
-				SizeType newCapacity = countOfContainer + count_;
+				if (keptCount != readIndex) {
+					values[keptCount] = std::move(values[readIndex]);
+				}
+				const Type& element = values[keptCount];
+				keptCount += 1;
 				
-				Pointer newValues (newCapacity);
+				if (!isSearching) { continue; }
 				
-				std::move(&values[0], &values[count_], &newValues[0]);
-				newValues.moveValuesFrom(newElements, count_);
+				while (matchedCount > 0 && !(element == *pattern[matchedCount])) {
+					matchedCount = fallback[matchedCount-1];
+				}
+				if (element == *pattern[matchedCount]) {
+					matchedCount += 1;
+				}
 				
-				values = std::move(newValues);
+				if (matchedCount == patternCount) {
+					keptCount -= patternCount;
+					matchedCount = (keptCount > 0) ? matchedCountAt[keptCount-1] : 0;
+					isSearching = !onlyFirstOcurrence;
+				} else {
+					matchedCountAt[keptCount-1] = matchedCount;
+				}
 			}
 			
-			count_ += countOfContainer;
+			truncateToCount(keptCount);
+			shrinkAfterRemoval();
 			
 			return *this;
 		}
 		
-		template <typename Container>
-		Array& removeElementsFromContainer(const Container& newElements, bool onlyFirstOcurrence = false) {
+		/// Keeps the elements that don't satisfy shouldBeRemoved, in the same order, in a single pass
+		template <typename Predicate>
+		CONSTEXPR void removeElementsWhere(const Predicate& shouldBeRemoved) {
+			truncateToCount(std::remove_if(this->begin(), this->end(), shouldBeRemoved) - this->begin());
+			shrinkAfterRemoval();
+		}
+		
+		/// Removes [first, last), the next elements are shifted only once
+		CONSTEXPR void removeRange(const SizeType first, const SizeType last, const bool shrinks = true) {
 			
-			SizeType elementsFound = 0;
-			SizeType countOfContainer = std::distance(std::begin(newElements), std::end(newElements));
-			std::unique_ptr<SizeType[]> elementsPosition(new SizeType[countOfContainer]);
+			if (first >= last) { return; }
 			
-			auto newElement = std::begin(newElements);
+			if (relocatesWithMemcpy) {
+				values.destroyRange(first, last);
+				std::memmove(static_cast<void*>(this->begin() + first), static_cast<const void*>(this->begin() + last), (count_ - last) * sizeof(Type));
+				count_ -= (last - first);
+			} else {
+				std::move(this->begin() + last, this->end(), this->begin() + first);
+				truncateToCount(count_ - (last - first));
+			}
 			
-			do {
-				elementsFound = 0;
-				newElement = std::begin(newElements);
-				
-				for (SizeType index = 0; index < count_; ++index) {
-					
-					if (values[index] == *newElement) {
-						elementsPosition[elementsFound] = index;
-						elementsFound += 1;
-						++newElement;
-					}
-					else if (elementsFound != newElements.size()) {
-						elementsFound = 0;
-						newElement = std::begin(newElements);
-					} else { break; }
-				}
-				
-				if (elementsFound == newElements.size()) {
-					for (SizeType i = 0; i < newElements.size(); ++i) {
-						this->removeAt(elementsPosition[0]);
-					}
+			if (shrinks) {
+				shrinkAfterRemoval();
+			}
+		}
+		
+		/// Reduces the memory if the growth policy says so, called once after a removal.
+		/// Elements that fit in the inline storage go back to it (unless the policy never shrinks)
+		CONSTEXPR void shrinkAfterRemoval() {
+			
+			if (InlineCapacity > 0 && count_ <= InlineCapacity && !this->isUsingInlineValues()) {
+				if (GrowthPolicy::shrunkCapacity(values.capacity(), 0, sizeof(Type)) < values.capacity()) {
+					resizeValuesToSize(InlineCapacity);
 				}
-			} while((elementsFound == newElements.size()) && !onlyFirstOcurrence);
+				return;
+			}
 			
-			return *this;
+			const SizeType newCapacity = GrowthPolicy::shrunkCapacity(values.capacity(), count_, sizeof(Type));
+			
+			if (newCapacity < values.capacity()) {
+				resizeValuesToSize(newCapacity);
+			}
 		}
 		
 		CONSTEXPR void checkIfEmpty() const {
@@ -212,20 +410,36 @@ namespace evt {
 		
 		void assignArrayWithOptionalInitialCapacity(const Array& otherArray, const size_t initialCapacity = 2) {
 			if (this != &otherArray) {
-				count_ = otherArray.count();
-				std::size_t capacity = (otherArray.count() > initialCapacity) ? otherArray.count() : initialCapacity;
-				assignMemoryAndCapacityForSize(capacity);
-				values.copyValuesFrom(otherArray);
+				assignNewElements(otherArray.begin(), otherArray.end(), initialCapacity);
 			}
 		}
 		
-		void assignArrayWithOptionalInitialCapacity(Array&& otherArray, const size_t initialCapacity = 2) {
-			if (this != &otherArray) {
-				count_ = otherArray.count();
-				std::size_t capacity = (otherArray.count() > initialCapacity) ? otherArray.count() : initialCapacity;
-				assignMemoryAndCapacityForSize(capacity);
-				values.moveValuesFrom(std::move(otherArray));
+		/// Takes the memory of another array, which is left empty. Inline memory belongs to its array, so those elements are moved instead
+		CONSTEXPR void takeValuesFrom(Array& otherArray) noexcept(isNothrowMovable) {
+			
+			truncateToCount(0);
+			
+			if (otherArray.isUsingInlineValues()) {
+				
+				if (!this->isUsingInlineValues()) {
+					values = initialValues(0, otherArray.values.allocator());
+				}
+				
+				if (relocatesWithMemcpy) {
+					if (otherArray.count_ > 0) {
+						std::memcpy(static_cast<void*>(values.data()), static_cast<const void*>(otherArray.begin()), otherArray.count_ * sizeof(Type));
+					}
+				} else {
+					std::uninitialized_copy(std::make_move_iterator(otherArray.begin()), std::make_move_iterator(otherArray.end()), values.data());
+					otherArray.values.destroyRange(0, otherArray.count_);
+				}
+			} else {
+				values = std::move(otherArray.values);
+				otherArray.values = otherArray.initialValues(0, values.allocator());
 			}
+			
+			count_ = otherArray.count_;
+			otherArray.count_ = 0;
 		}
 		
 	public:
@@ -233,16 +447,29 @@ namespace evt {
 		// MARK: Constructors
 		
 		CONSTEXPR Array() {}
-		CONSTEXPR Array(const int initialCapacity) { assignMemoryAndCapacityForSize(initialCapacity, true); }
-		CONSTEXPR Array(std::size_t initialCapacity) { assignMemoryAndCapacityForSize(initialCapacity, true); }
-		CONSTEXPR Array(InitializerList&& elements, std::size_t initialCapacity = 2) { assignNewMagicElements(elements, initialCapacity); }
-		CONSTEXPR Array(const Array& otherArray, std::size_t initialCapacity = 2) { assignArrayWithOptionalInitialCapacity(otherArray, initialCapacity); }
-		CONSTEXPR Array(Array&& otherArray, std::size_t initialCapacity = 2) { assignArrayWithOptionalInitialCapacity(std::move(otherArray), initialCapacity); }
+		CONSTEXPR Array(const int initialCapacity) { replaceEmptyValues(initialCapacity); }
+		CONSTEXPR Array(std::size_t initialCapacity) { replaceEmptyValues(initialCapacity); }
+		CONSTEXPR Array(const Allocator& allocator): values(initialValues(0, allocator)) {}
+		CONSTEXPR Array(std::size_t initialCapacity, const Allocator& allocator): values(initialValues(initialCapacity, allocator)) {}
+		CONSTEXPR Array(InitializerList&& elements, std::size_t initialCapacity = 2) { assignNewElements(elements.begin(), elements.end(), initialCapacity); }
+		CONSTEXPR Array(const Array& otherArray, std::size_t initialCapacity = 2): values(initialValues(0, otherArray.values.allocator())) {
+			assignArrayWithOptionalInitialCapacity(otherArray, initialCapacity);
+		}
+		CONSTEXPR Array(Array&& otherArray) noexcept(isNothrowMovable): values(initialValues(0, otherArray.values.allocator())) {
+			takeValuesFrom(otherArray);
+		}
+		CONSTEXPR Array(Array&& otherArray, std::size_t initialCapacity): values(initialValues(0, otherArray.values.allocator())) {
+			takeValuesFrom(otherArray);
+			if (initialCapacity > values.capacity()) {
+				resizeValuesToSize(initialCapacity);
+			}
+		}
 		CONSTEXPR Array(const SizeType count, const Type& initialValue) {
-			assignMemoryAndCapacityForSize(count);
-			this->count_ = count;
+			replaceEmptyValues(count);
 			Type n {initialValue};
-			std::generate(this->begin(), this->end(), [&]{ return n++; });
+			for (; count_ < count; ++count_) {
+				values.constructAt(count_, n++);
+			}
 		}
 		
 		CONSTEXPR Array(evt::ArithmeticRange<size_t> range) {
@@ -253,16 +480,22 @@ namespace evt {
 		}
 		
 		template <typename Container, typename = typename std::enable_if<
-		!std::is_same<Container,Array>::value &&
+		!std::is_same<typename std::decay<Container>::type,Array>::value &&
 		!std::is_same<Container,Type>::value &&
+		!std::is_convertible<Container,Allocator>::value &&
 		!std::is_arithmetic<Container>::value>::type>
-		CONSTEXPR Array(Container&& elements, SizeType initialCapacity = 2) { assignNewMagicElements(elements, initialCapacity); }
+		CONSTEXPR Array(Container&& elements, SizeType initialCapacity = 2) { assignNewElements(std::begin(elements), std::end(elements), initialCapacity); }
+		
+		~Array() {
+			values.destroyRange(0, count_);
+		}
 		
 		// MARK: Capacity
 		
 		CONSTEXPR SizeType size() const  { return count_; }
 		CONSTEXPR SizeType count() const { return count_; }
 		CONSTEXPR SizeType capacity() const { return values.capacity(); }
+		CONSTEXPR const Allocator& allocator() const { return values.allocator(); }
 		
 		CONSTEXPR bool isEmpty() const { return (count_ == 0); }
 		
@@ -270,14 +503,14 @@ namespace evt {
 		
 		CONSTEXPR void insertAt(const Type* position, const Type& newElement) {
 			
-			if (position == &values[count_]) {
+			if (position == this->end()) {
 				this->append(newElement);
 			}
-			else if (position == &values[0]) {
+			else if (position == this->begin()) {
 				this->insert(newElement, 0);
 			}
-			else if (position > &values[0] && position < &values[count_]) {
-				this->insert(newElement, position - &values[0]);
+			else if (position > this->begin() && position < this->end()) {
+				this->insert(newElement, position - this->begin());
 			}
 			else {
 				throw std::out_of_range("Index out of range");
@@ -286,50 +519,26 @@ namespace evt {
 		
 		CONSTEXPR void insertAt(const Type* position, Type&& newElement) {
 			
-			if (position == &values[count_]) {
+			if (position == this->end()) {
 				this->append(std::move(newElement));
 			}
-			else if (position == &values[0]) {
+			else if (position == this->begin()) {
 				this->insert(std::move(newElement), 0);
 			}
-			else if (position > &values[0] && position < &values[count_]) {
-				this->insert(std::move(newElement), position - &values[0]);
+			else if (position > this->begin() && position < this->end()) {
+				this->insert(std::move(newElement), position - this->begin());
 			}
 			else {
 				throw std::out_of_range("Index out of range");
 			}
 		}
 		
-		CONSTEXPR void insert(const Type& newElement, const SizeType index, const SizeType capacityResizeFactor = 2) {
-			
-			if (index != 0) {
-				checkIfOutOfRange(index);
-			}
-			else if (index == count_ || this->isEmpty()) {
-				this->append(newElement);
-				return;
-			}
-			
-			if (values.capacity() == count_) {
-				
-				SizeType newCapacity = values.capacity() * capacityResizeFactor;
-				
-				Pointer newValues (newCapacity);
-				
-				std::copy(&values[0], &values[index], &newValues[0]);
-				newValues.copyValuesFrom(values, index+1);
-				
-				values = std::move(newValues);
-			}
-			else {
-				std::copy(&values[index], &values[count_], &values[index + 1]);
-			}
-			
-			values[index] = newElement;
-			count_ += 1;
+		CONSTEXPR void insert(const Type& newElement, const SizeType index, const SizeType capacityResizeFactor = 0) {
+			// The copy is done first, so the element can safely come from this same array
+			this->insert(Type(newElement), index, capacityResizeFactor);
 		}
 		
-		CONSTEXPR void insert(Type&& newElement, const SizeType index, const SizeType capacityResizeFactor = 2) {
+		CONSTEXPR void insert(Type&& newElement, const SizeType index, const SizeType capacityResizeFactor = 0) {
 			
 			if (index != 0) {
 				checkIfOutOfRange(index);
@@ -339,22 +548,36 @@ namespace evt {
 				return;
 			}
 			
-			if (values.capacity() == count_) {
+			if (relocatesWithMemcpy) {
+				
+				Type element(std::move(newElement));
 				
-				SizeType newCapacity = values.capacity() * capacityResizeFactor;
+				if (values.capacity() == count_) {
+					resizeValuesToSize(grownCapacity(capacityResizeFactor, count_ + 1));
+				}
+				
+				relocateValuesOneRight(index);
+				values.constructAt(index, std::move(element));
+			}
+			else if (values.capacity() == count_) {
 				
-				Pointer newValues (newCapacity);
+				Pointer newValues = allocateValues(grownCapacity(capacityResizeFactor, count_ + 1));
 				
-				std::move(&values[0], &values[index], &newValues[0]);
-				newValues.moveValuesFrom(values, index+1);
+				newValues.constructAt(index, std::move(newElement));
+				std::uninitialized_copy(std::make_move_iterator(this->begin() + index), std::make_move_iterator(this->end()), newValues.data() + index + 1);
+				values.destroyRange(index, count_);
 				
-				values = std::move(newValues);
+				SizeType oldCount = count_;
+				count_ = index;
+				relocateValuesTo(newValues);
+				count_ = oldCount;
 			}
 			else {
-				std::move(&values[index], &values[count_], &values[index + 1]);
+				values.constructAt(count_, std::move(values[count_ - 1]));
+				std::move_backward(this->begin() + index, this->end() - 1, this->end());
+				values[index] = std::move(newElement);
 			}
 			
-			values[index] = newElement;
 			count_ += 1;
 		}
 		
@@ -369,32 +592,36 @@ namespace evt {
 			}
 			checkIfOutOfRange(last);
 			
-			std::copy(&values[first], &values[last+1], &values[0]);
-			
-			SizeType newCount = last-first + 1;
-			
-			if (newCount < (count_ / 4.0)) {
-				resize(newCount);
+			if (relocatesWithMemcpy) {
+				values.destroyRange(0, first);
+				values.destroyRange(last + 1, count_);
+				std::memmove(static_cast<void*>(this->begin()), static_cast<const void*>(this->begin() + first), (last-first + 1) * sizeof(Type));
+				count_ = last-first + 1;
 			} else {
-				count_ = newCount;
+				std::move(this->begin() + first, this->begin() + last + 1, this->begin());
+				truncateToCount(last-first + 1);
 			}
+			
+			shrinkAfterRemoval();
 		}
 		
-		CONSTEXPR void append(const Type& newElement, const SizeType capacityResizeFactor = 2) {
+		CONSTEXPR void append(const Type& newElement, const SizeType capacityResizeFactor = 0) {
 			
 			if (values.capacity() == count_) {
-				resizeValuesToSize(values.capacity() * capacityResizeFactor);
+				growAndAppend(newElement, capacityResizeFactor);
+			} else {
+				values.constructAt(count_, newElement);
 			}
-			values[count_] = newElement;
 			count_ += 1;
 		}
 		
-		CONSTEXPR void append(Type&& newElement, const SizeType capacityResizeFactor = 2) {
+		CONSTEXPR void append(Type&& newElement, const SizeType capacityResizeFactor = 0) {
 			
 			if (values.capacity() == count_) {
-				resizeValuesToSize(values.capacity() * capacityResizeFactor, true);
+				growAndAppend(std::move(newElement), capacityResizeFactor);
+			} else {
+				values.constructAt(count_, std::move(newElement));
 			}
-			values[count_] = std::move(newElement);
 			count_ += 1;
 		}
 		
@@ -405,7 +632,25 @@ namespace evt {
 		CONSTEXPR void appendElements(const Container& newElements) { appendNewElements(newElements); }
 		
 		template<typename Container>
-		CONSTEXPR void appendElements(Container&& newElements) { appendNewElementsMOVE(std::move(newElements)); }
+		CONSTEXPR void appendElements(Container&& newElements) { appendNewElementsMOVE(std::forward<Container>(newElements)); }
+		
+		/// Makes room for count elements at the end and lets fill(Type* first) write them directly in the array memory.
+		/// fill returns how many elements it wrote (up to count), only those are appended
+		template <typename Fill>
+		SizeType appendUninitialized(const SizeType count, const Fill& fill) {
+			
+			static_assert(std::is_trivially_copyable<Type>::value, "Only trivially copyable elements can be written directly");
+			
+			if (values.capacity() - count_ < count) {
+				resizeValuesToSize(grownCapacity(0, count_ + count));
+			}
+			
+			SizeType writtenCount = fill(this->end());
+			if (writtenCount > count) { writtenCount = count; }
+			
+			count_ += writtenCount;
+			return writtenCount;
+		}
 		
 		/// Only reserves new memory if the new size if bigger than the array capacity
 		CONSTEXPR void reserve(const SizeType newSize) {
@@ -415,9 +660,8 @@ namespace evt {
 				return;
 			}
 			
-			if (newSize < count_) {
-				count_ = newSize;
-			}
+			truncateToCount(newSize);
+			
 			if (newSize > values.capacity()) {
 				resizeValuesToSize(newSize);
 			}
@@ -431,9 +675,7 @@ namespace evt {
 				return;
 			}
 			
-			if (newSize < count_) {
-				count_ = newSize;
-			}
+			truncateToCount(newSize);
 			resizeValuesToSize(newSize);
 		}
 		
@@ -451,51 +693,34 @@ namespace evt {
 			removeAll(true);
 		}
 		
-		/// Removes all elements in array, capacity will be 1 if desired
+		/// Removes all elements in array, its memory is released too unless keepCapacity (a SmallArray goes back to its inline storage)
 		CONSTEXPR void removeAll(const bool keepCapacity = false) {
-			if (!keepCapacity) {
-				assignMemoryAndCapacityForSize(2, true);
+			truncateToCount(0);
+			if (!keepCapacity && !this->isUsingInlineValues()) {
+				values = initialValues(0, values.allocator());
 			}
-			count_ = 0;
 		}
 		
 		CONSTEXPR void removeAt(const SizeType index, const bool shrinkIfEmpty = true) {
 			
 			if (index == count_ - 1) {
-				removeLast();
+				removeLast(shrinkIfEmpty);
 				return;
 			}
 			
-			if (count_ == 2 && shrinkIfEmpty) {
-				shrink();
-			}
-			
 			checkIfEmpty();
 			checkIfOutOfRange(index);
 			
-			std::copy(&values[index + 1], &values[count_], &values[index]);
-			
-			if (count_ - 1 < (values.capacity() / 4.0)) {
-				resize(count_ - 1);
-			}
-			else {
-				count_ -= 1;
-			}
+			removeRange(index, index + 1, shrinkIfEmpty);
 		}
 		
 		CONSTEXPR void removeLast(const bool shrinkIfEmpty = true) {
 			
-			if (count_ == 2 && shrinkIfEmpty) {
-				shrink();
-			}
-			
 			checkIfEmpty();
+			truncateToCount(count_ - 1);
 			
-			if (count_ - 1 < (values.capacity() / 4.0)) {
-				resize(count_ - 1);
-			}
-			else {
-				count_ -= 1;
+			if (shrinkIfEmpty) {
+				shrinkAfterRemoval();
 			}
 		}
 		
@@ -504,23 +729,38 @@ namespace evt {
 		}
 		
 		CONSTEXPR void removeSubrange(const SizeType startPosition, const SizeType endPosition, bool lessEqual = true) {
-			for (SizeType i = startPosition; lessEqual ? (i <= endPosition) : (i < endPosition); ++i) {
-				this->removeAt(startPosition);
-			}
+			
+			const SizeType last = lessEqual ? (endPosition + 1) : endPosition;
+			if (startPosition >= last) { return; }
+			
+			checkIfOutOfRange(last - 1);
+			removeRange(startPosition, last);
 		}
 		
 		CONSTEXPR void removeSubrange(std::initializer_list<int> position, bool lessEqual = true) {
-			
-			SizeType startPosition = *std::begin(position);
-			SizeType endPosition = *(std::end(position)-1);
-			
-			for (SizeType i = startPosition; lessEqual ? (i <= endPosition) : (i < endPosition); ++i) {
-				this->removeAt(startPosition);
-			}
+			this->removeSubrange(*std::begin(position), *(std::end(position)-1), lessEqual);
+		}
+		
+		/// Removes the elements that satisfy the condition, with a single pass and at most one reallocation
+		template <typename Function, typename = internalEVT::IfCallableAs<Function, bool(const Type&)>>
+		CONSTEXPR void removeAll(const Function& shouldBeRemoved) {
+			removeElementsWhere(shouldBeRemoved);
+		}
+		
+		CONSTEXPR void removeAll(std::function<bool(const Type&)> shouldBeRemoved) {
+			this->removeAll<std::function<bool(const Type&)>>(shouldBeRemoved);
 		}
 		
 		CONSTEXPR void swap(Array& otherArray) {
 			
+			// Inline memory belongs to its array, so the elements are moved instead
+			if (this->isUsingInlineValues() || otherArray.isUsingInlineValues()) {
+				Array auxArray(std::move(*this));
+				*this = std::move(otherArray);
+				otherArray = std::move(auxArray);
+				return;
+			}
+			
 			Pointer auxValues = std::move(this->values);
 			this->values = std::move(otherArray.values);
 			otherArray.values = std::move(auxValues);
@@ -545,77 +785,99 @@ namespace evt {
 		}
 		
 		CONSTEXPR bool contains(const Type& element) const {
-			for (const Type& elm: (*this)) {
-				if (element == elm) { return true; }
-			}
-			return false;
+			return this->find(element) < count_;
 		}
 		
-		CONSTEXPR bool contains(std::function<bool(const Type&)> condition) const {
+		template <typename Function, typename = internalEVT::IfCallableAs<Function, bool(const Type&)>>
+		CONSTEXPR bool contains(const Function& condition) const {
 			for (const Type& elm: (*this)) {
 				if (condition(elm)) { return true; }
 			}
 			return false;
 		}
 		
-		// TODO: Needs to be improved
-		inline bool parallelContains(const Type& element) const {
-			
-			bool isElementFound = false;
-			
-			std::thread firstHalf([&] {
-				const size_t halfElementsCount = size_t(this->count_ / 2.0);
-				size_t i = 0;
-				while(!isElementFound && i < halfElementsCount) {
-					if (element == this->values[i]) { isElementFound = true; return; }
-					i++;
-				}
-			}), secondHalf([&] {
-				size_t j = size_t(this->count_ / 2.0);
-				while(!isElementFound && j < this->count_) {
-					if (element == this->values[j]) { isElementFound = true; return; }
-					j++;
+		CONSTEXPR bool contains(std::function<bool(const Type&)> condition) const {
+			return this->contains<std::function<bool(const Type&)>>(condition);
+		}
+		
+		template <typename Function, typename = internalEVT::IfCallableAs<Function, void(Type&)>>
+		void parallelForEach(const Function& function, ThreadPool& pool = ThreadPool::shared()) {
+			pool.parallelFor(count_, elementsPerParallelChunk, [&](const SizeType first, const SizeType last) {
+				for (SizeType index = first; index < last; ++index) {
+					function(values[index]);
 				}
 			});
-			
-			firstHalf.join();
-			secondHalf.join();
-			
-			return isElementFound;
 		}
 		
-		inline bool parallelContains(std::function<bool(const Type&)> condition) const {
-			
-			bool isElementFound = false;
-			
-			std::thread firstHalf([&] {
-				const size_t halfElementsCount = size_t(this->count_ / 2.0);
-				size_t i = 0;
-				while(!isElementFound && i < halfElementsCount) {
-					if (condition(this->values[i])) { isElementFound = true; return; }
-					i++;
-				}
-			}), secondHalf([&] {
-				size_t j = size_t(this->count_ / 2.0);
-				while(!isElementFound && j < this->count_) {
-					if (condition(this->values[j])) { isElementFound = true; return; }
-					j++;
+		template <typename Function, typename = internalEVT::IfCallableAs<Function, void(const Type&)>>
+		void parallelForEach(const Function& function, ThreadPool& pool = ThreadPool::shared()) const {
+			pool.parallelFor(count_, elementsPerParallelChunk, [&](const SizeType first, const SizeType last) {
+				for (SizeType index = first; index < last; ++index) {
+					function(values[index]);
 				}
 			});
-			
-			firstHalf.join();
-			secondHalf.join();
-			
-			return isElementFound;
+		}
+		
+		void parallelForEach(std::function<void(Type&)> function, ThreadPool& pool = ThreadPool::shared()) {
+			this->parallelForEach<std::function<void(Type&)>>(function, pool);
+		}
+		
+		void parallelForEach(std::function<void(const Type&)> function, ThreadPool& pool = ThreadPool::shared()) const {
+			this->parallelForEach<std::function<void(const Type&)>>(function, pool);
+		}
+		
+		inline bool parallelContains(const Type& element, ThreadPool& pool = ThreadPool::shared()) const {
+			return this->parallelFind(element, pool) < count_;
+		}
+		
+		template <typename Function, typename = internalEVT::IfCallableAs<Function, bool(const Type&)>>
+		inline bool parallelContains(const Function& condition, ThreadPool& pool = ThreadPool::shared()) const {
+			return this->parallelFindIf(condition, pool) < count_;
+		}
+		
+		inline bool parallelContains(std::function<bool(const Type&)> condition, ThreadPool& pool = ThreadPool::shared()) const {
+			return this->parallelContains<std::function<bool(const Type&)>>(condition, pool);
 		}
 		 
 		/// Returns the index of the first ocurrence of the element. Last position if the element isn't found
 		CONSTEXPR SizeType find(const Type& element) const {
-			return (std::find(&values[0], &values[count_], element) - &values[0]);
+			return simd::find(this->begin(), count_, element);
+		}
+		
+		template <typename Function, typename = internalEVT::IfCallableAs<Function, bool(const Type&)>>
+		CONSTEXPR SizeType findIf(const Function& findFunction) const {
+			return (std::find_if(this->begin(), this->end(), findFunction) - this->begin());
 		}
 		
 		CONSTEXPR SizeType findIf(std::function<bool(const Type&)> findFunction) const {
-			return (std::find_if(&values[0], &values[count_], findFunction) - &values[0]);
+			return this->findIf<std::function<bool(const Type&)>>(findFunction);
+		}
+		
+		/// Same as findIf, the chunks after a found element stop early
+		template <typename Function, typename = internalEVT::IfCallableAs<Function, bool(const Type&)>>
+		SizeType parallelFindIf(const Function& findFunction, ThreadPool& pool = ThreadPool::shared()) const {
+			
+			std::atomic<SizeType> foundIndex {count_};
+			
+			pool.parallelFor(count_, elementsPerParallelChunk, [&](const SizeType first, const SizeType last) {
+				for (SizeType index = first; index < last && index < foundIndex.load(std::memory_order_relaxed); ++index) {
+					if (findFunction(values[index])) {
+						SizeType currentIndex = foundIndex.load();
+						while (index < currentIndex && !foundIndex.compare_exchange_weak(currentIndex, index)) {}
+						return;
+					}
+				}
+			});
+			
+			return foundIndex;
+		}
+		
+		SizeType parallelFindIf(std::function<bool(const Type&)> findFunction, ThreadPool& pool = ThreadPool::shared()) const {
+			return this->parallelFindIf<std::function<bool(const Type&)>>(findFunction, pool);
+		}
+		
+		SizeType parallelFind(const Type& element, ThreadPool& pool = ThreadPool::shared()) const {
+			return this->parallelFindIf([&element](const Type& otherElement) { return element == otherElement; }, pool);
 		}
 		
 		/// Returns an Array of positions with all the ocurrences of the element
@@ -708,8 +970,14 @@ namespace evt {
 			return this->operator==(elements);
 		}
 		
-		CONSTEXPR Array filter(std::function<bool(const Type&)> filterFunction) const {
-			Array filteredArray;
+		/// Lazy view of the elements, its filter/map/take... stages don't create intermediate arrays
+		LazyView<internalEVT::LazyArraySource<Type>> lazy() const {
+			return LazyView<internalEVT::LazyArraySource<Type>>(internalEVT::LazyArraySource<Type>(this->begin(), this->end()));
+		}
+		
+		template <typename Function, typename = internalEVT::IfCallableAs<Function, bool(const Type&)>>
+		CONSTEXPR Array filter(const Function& filterFunction) const {
+			Array filteredArray(values.allocator());
 			for (const auto& element: *this) {
 				if (filterFunction(element)) {
 					filteredArray.append(element);
@@ -717,22 +985,114 @@ namespace evt {
 			}
 			return filteredArray;
 		}
-			
-		template <typename MapType>
-		Array<MapType> map(std::function<MapType(const Type&)> mapFunctor) const {
-			Array<MapType> mappedArray(this->count());
+		
+		CONSTEXPR Array filter(std::function<bool(const Type&)> filterFunction) const {
+			return this->filter<std::function<bool(const Type&)>>(filterFunction);
+		}
+		
+		/// The element type is the result of mapFunctor unless MapType is given
+		template <typename MapType = void, typename Function, typename Result = internalEVT::MapResult<MapType, Function, const Type&>>
+		Array<Result> map(const Function& mapFunctor) const {
+			Array<Result> mappedArray(this->count());
 			for (const auto& element: *this) {
 				mappedArray.append(mapFunctor(element));
 			}
 			return mappedArray;
 		}
+		
+		template <typename MapType>
+		Array<MapType> map(std::function<MapType(const Type&)> mapFunctor) const {
+			return this->map<MapType, std::function<MapType(const Type&)>>(mapFunctor);
+		}
 			
 		Array map(std::function<Type(const Type&)> mapFunctor) const {
-			return this->map<Type>(mapFunctor);
+			return this->map<Type, std::function<Type(const Type&)>>(mapFunctor);
 		}
+		
+		template <typename MapType = void, typename Function, typename Result = internalEVT::MapResult<MapType, Function, const Type&>>
+		Array<Result> parallelMap(const Function& mapFunctor, ThreadPool& pool = ThreadPool::shared()) const {
 			
-		template <typename ReduceType>
-		ReduceType reduce(std::function<ReduceType(const ReduceType result, const Type&)> reduceFunctor, ReduceType initialValue = ReduceType()) const {
+			Array<Result> mappedArray(this->count());
+			if (this->isEmpty()) { return mappedArray; }
+			
+			const SizeType chunkSize = pool.chunkSizeFor(count_, elementsPerParallelChunk);
+			RawPointer<bool[]> isChunkMapped((count_ + chunkSize - 1) / chunkSize);
+			
+			try {
+				pool.parallelFor(count_, elementsPerParallelChunk, [&](const SizeType first, const SizeType last) {
+					SizeType index = first;
+					try {
+						for (; index < last; ++index) {
+							mappedArray.values.constructAt(index, mapFunctor(values[index]));
+						}
+					} catch (...) {
+						mappedArray.values.destroyRange(first, index);
+						throw;
+					}
+					isChunkMapped[first / chunkSize] = true;
+				});
+			} catch (...) {
+				for (SizeType first = 0; first < count_; first += chunkSize) {
+					if (isChunkMapped[first / chunkSize]) {
+						mappedArray.values.destroyRange(first, std::min(count_, first + chunkSize));
+					}
+				}
+				throw;
+			}
+			
+			mappedArray.count_ = count_;
+			return mappedArray;
+		}
+		
+		template <typename MapType>
+		Array<MapType> parallelMap(std::function<MapType(const Type&)> mapFunctor, ThreadPool& pool = ThreadPool::shared()) const {
+			return this->parallelMap<MapType, std::function<MapType(const Type&)>>(mapFunctor, pool);
+		}
+		
+		Array parallelMap(std::function<Type(const Type&)> mapFunctor, ThreadPool& pool = ThreadPool::shared()) const {
+			return this->parallelMap<Type, std::function<Type(const Type&)>>(mapFunctor, pool);
+		}
+		
+		/// Same order as filter, each chunk is filtered on its own and the results are joined
+		template <typename Function, typename = internalEVT::IfCallableAs<Function, bool(const Type&)>>
+		Array parallelFilter(const Function& filterFunction, ThreadPool& pool = ThreadPool::shared()) const {
+			
+			Array filteredArray(values.allocator());
+			if (this->isEmpty()) { return filteredArray; }
+			
+			const SizeType chunkSize = pool.chunkSizeFor(count_, elementsPerParallelChunk);
+			RawPointer<Array[]> filteredChunks((count_ + chunkSize - 1) / chunkSize);
+			
+			pool.parallelFor(count_, elementsPerParallelChunk, [&](const SizeType first, const SizeType last) {
+				Array& filteredChunk = filteredChunks[first / chunkSize];
+				for (SizeType index = first; index < last; ++index) {
+					if (filterFunction(values[index])) {
+						filteredChunk.append(values[index]);
+					}
+				}
+			});
+			
+			SizeType filteredCount = 0;
+			for (const Array& filteredChunk: filteredChunks) {
+				filteredCount += filteredChunk.count();
+			}
+			
+			filteredArray.reserve(filteredCount);
+			for (Array& filteredChunk: filteredChunks) {
+				for (Type& element: filteredChunk) {
+					filteredArray.append(std::move(element));
+				}
+			}
+			
+			return filteredArray;
+		}
+		
+		Array parallelFilter(std::function<bool(const Type&)> filterFunction, ThreadPool& pool = ThreadPool::shared()) const {
+			return this->parallelFilter<std::function<bool(const Type&)>>(filterFunction, pool);
+		}
+		
+		template <typename ReduceType, typename Function, typename = internalEVT::IfCallableAs<Function, ReduceType(const ReduceType, const Type&)>>
+		ReduceType reduce(const Function& reduceFunctor, ReduceType initialValue = ReduceType()) const {
 			ReduceType reducedArrayValue{initialValue};
 			for (const auto& element: *this) {
 				reducedArrayValue = reduceFunctor(reducedArrayValue, element);
@@ -740,13 +1100,91 @@ namespace evt {
 			return reducedArrayValue;
 		}
 		
-		CONSTEXPR size_t sum() const {
-			return this->reduce<size_t>([](const size_t result, const Type& value){ return result + value; });
+		template <typename ReduceType>
+		ReduceType reduce(std::function<ReduceType(const ReduceType result, const Type&)> reduceFunctor, ReduceType initialValue = ReduceType()) const {
+			return this->reduce<ReduceType, std::function<ReduceType(const ReduceType, const Type&)>>(reduceFunctor, initialValue);
+		}
+		
+		/// initialValue is the start of every chunk, so it must be neutral for reduceFunctor and combineFunctor (0 for a sum)
+		template <typename ReduceType, typename ReduceFunction, typename CombineFunction,
+				  typename = internalEVT::IfCallableAs<ReduceFunction, ReduceType(const ReduceType, const Type&)>,
+				  typename = internalEVT::IfCallableAs<CombineFunction, ReduceType(const ReduceType, const ReduceType)>>
+		ReduceType parallelReduce(const ReduceFunction& reduceFunctor,
+								  const CombineFunction& combineFunctor,
+								  ReduceType initialValue = ReduceType(),
+								  ThreadPool& pool = ThreadPool::shared()) const {
+			
+			if (this->isEmpty()) { return initialValue; }
+			
+			const SizeType chunkSize = pool.chunkSizeFor(count_, elementsPerParallelChunk);
+			const SizeType chunkCount = (count_ + chunkSize - 1) / chunkSize;
+			RawPointer<ReduceType[]> reducedChunks(chunkCount);
+			
+			pool.parallelFor(count_, elementsPerParallelChunk, [&](const SizeType first, const SizeType last) {
+				ReduceType reducedChunk {initialValue};
+				for (SizeType index = first; index < last; ++index) {
+					reducedChunk = reduceFunctor(reducedChunk, values[index]);
+				}
+				reducedChunks[first / chunkSize] = std::move(reducedChunk);
+			});
+			
+			ReduceType reducedArrayValue {std::move(reducedChunks[0])};
+			for (SizeType chunk = 1; chunk < chunkCount; ++chunk) {
+				reducedArrayValue = combineFunctor(reducedArrayValue, reducedChunks[chunk]);
+			}
+			return reducedArrayValue;
+		}
+		
+		template <typename ReduceType>
+		ReduceType parallelReduce(std::function<ReduceType(const ReduceType result, const Type&)> reduceFunctor,
+								  std::function<ReduceType(const ReduceType, const ReduceType)> combineFunctor,
+								  ReduceType initialValue = ReduceType(),
+								  ThreadPool& pool = ThreadPool::shared()) const {
+			return this->parallelReduce<ReduceType, std::function<ReduceType(const ReduceType, const Type&)>, std::function<ReduceType(const ReduceType, const ReduceType)>>(reduceFunctor, combineFunctor, initialValue, pool);
+		}
+		
+		/// reduceFunctor is also used to combine the chunks, so it must be associative
+		template <typename Function, typename = internalEVT::IfCallableAs<Function, Type(const Type, const Type&)>>
+		Type parallelReduce(const Function& reduceFunctor, Type initialValue = Type(), ThreadPool& pool = ThreadPool::shared()) const {
+			return this->parallelReduce<Type, Function, Function>(reduceFunctor, reduceFunctor, initialValue, pool);
+		}
+		
+		Type parallelReduce(std::function<Type(const Type, const Type&)> reduceFunctor, Type initialValue = Type(), ThreadPool& pool = ThreadPool::shared()) const {
+			return this->parallelReduce<std::function<Type(const Type, const Type&)>>(reduceFunctor, initialValue, pool);
+		}
+		
+		/// Integers are added as 64 bit integers and floats as doubles (see simd::SumType), floating point values are added pairwise
+		typename simd::SumType<Type>::type sum() const {
+			return simd::sum(this->begin(), count_);
+		}
+		
+		typename simd::SumType<Type>::type sum(const simd::SummationMethod method) const {
+			return simd::sum(this->begin(), count_, method);
 		}
 		
 		CONSTEXPR double mean() const {
 			return double(this->sum()) / double(this->count());
 		}
+		
+		/// Index of the first smallest element
+		SizeType argmin() const {
+			checkIfEmpty();
+			return simd::argmin(this->begin(), count_);
+		}
+		
+		/// Index of the first biggest element
+		SizeType argmax() const {
+			checkIfEmpty();
+			return simd::argmax(this->begin(), count_);
+		}
+		
+		const Type& min() const {
+			return values[this->argmin()];
+		}
+		
+		const Type& max() const {
+			return values[this->argmax()];
+		}
 			
 		std::string joinToString(const std::string& separator = ", ",
 								 const std::string& prefix = "",
@@ -787,7 +1225,8 @@ namespace evt {
 			return this->joinToString(separator, "", "", -1, "...", transform);
 		}
 			
-		CONSTEXPR Optional<Type> first(std::function<bool(const Type&)> filterFunction) const {
+		template <typename Function, typename = internalEVT::IfCallableAs<Function, bool(const Type&)>>
+		CONSTEXPR Optional<Type> first(const Function& filterFunction) const {
 			for (const auto& element: *this) {
 				if (filterFunction(element)) {
 					return element;
@@ -796,7 +1235,12 @@ namespace evt {
 			return nullptr;
 		}
 		
-		Optional<Type> last(std::function<bool(const Type&)> filterFunction) const {
+		CONSTEXPR Optional<Type> first(std::function<bool(const Type&)> filterFunction) const {
+			return this->first<std::function<bool(const Type&)>>(filterFunction);
+		}
+		
+		template <typename Function, typename = internalEVT::IfCallableAs<Function, bool(const Type&)>>
+		Optional<Type> last(const Function& filterFunction) const {
 			
 			Optional<Type> optElement;
 			
@@ -809,12 +1253,21 @@ namespace evt {
 			return optElement;
 		}
 		
-		CONSTEXPR SizeType countOf(std::function<bool(const Type&)> countOfFunction) const {
+		Optional<Type> last(std::function<bool(const Type&)> filterFunction) const {
+			return this->last<std::function<bool(const Type&)>>(filterFunction);
+		}
+		
+		template <typename Function, typename = internalEVT::IfCallableAs<Function, bool(const Type&)>>
+		CONSTEXPR SizeType countOf(const Function& countOfFunction) const {
 			return std::count_if(this->begin(), this->end(), countOfFunction);
 		}
 		
+		CONSTEXPR SizeType countOf(std::function<bool(const Type&)> countOfFunction) const {
+			return this->countOf<std::function<bool(const Type&)>>(countOfFunction);
+		}
+		
 		CONSTEXPR SizeType countOf(const Type& value) const {
-			return std::count(this->begin(), this->end(), value);
+			return simd::countOf(this->begin(), count_, value);
 		}
 		
 		CONSTEXPR Optional<Type> at(const SizeType index) const {
@@ -869,7 +1322,7 @@ namespace evt {
 		
 		template <typename Container>
 		CONSTEXPR Array& operator+=(Container&& newElements) {
-			return appendNewElementsMOVE(std::move(newElements));
+			return appendNewElementsMOVE(std::forward<Container>(newElements));
 		}
 		
 		CONSTEXPR Array& operator+=(InitializerList newElements) {
@@ -880,7 +1333,7 @@ namespace evt {
 		CONSTEXPR bool operator==(const Container& elements) const {
 			SizeType countOfContainer = std::distance(std::begin(elements), std::end(elements));
 			if (count_ != countOfContainer) { return false; }
-			return std::equal(&values[0], &values[count_], std::begin(elements));
+			return std::equal(this->begin(), this->end(), std::begin(elements));
 		}
 		
 		template <typename Container>
@@ -962,12 +1415,10 @@ namespace evt {
 			return count_ >= countOfContainer;
 		}
 
-		Array& operator=(Array&& otherArray) {
+		Array& operator=(Array&& otherArray) noexcept(isNothrowMovable) {
 			
 			if (this != &otherArray) {
-				count_ = otherArray.count();
-				assignMemoryAndCapacityForSize(otherArray.capacity());
-				values.moveValuesFrom(std::move(otherArray));
+				takeValuesFrom(otherArray);
 			}
 			
 			return *this;
@@ -976,21 +1427,18 @@ namespace evt {
 		Array& operator=(const Array& otherArray) {
 			
 			if (this != &otherArray) {
+				truncateToCount(0);
+				if (values.capacity() < otherArray.capacity()) {
+					values = allocateValues(otherArray.capacity());
+				}
+				std::uninitialized_copy(otherArray.begin(), otherArray.end(), values.data());
 				count_ = otherArray.count();
-				assignMemoryAndCapacityForSize(otherArray.capacity());
-				values.copyValuesFrom(otherArray);
 			}
 			return *this;
 		}
 		
-		CONSTEXPR void moveFrom(Array&& otherArray) {
-			
-			if (this != &otherArray) {
-				values = std::move(otherArray.values);
-				count_ = otherArray.count_;
-				
-				otherArray.count_ = 0;
-			}
+		CONSTEXPR void moveFrom(Array&& otherArray) noexcept(isNothrowMovable) {
+			*this = std::move(otherArray);
 		}
 		 
 		// MARK: Shuffle
@@ -1005,7 +1453,7 @@ namespace evt {
 				std::mt19937_64 rng(rd());
 			#endif
 			
-			std::shuffle(&values[0], &values[count_], rng);
+			std::shuffle(this->begin(), this->end(), rng);
 		}
 		
 		CONSTEXPR Array shuffled() const {
@@ -1022,11 +1470,17 @@ namespace evt {
 		 
 		// MARK: Sort
 		
-		CONSTEXPR void sort(std::function<bool(Type&,Type&)> compareFunction = std::less_equal<Type>()) {
-			std::sort(&values[0], &values[count_], compareFunction);
+		template <typename Compare = std::less<Type>>
+		CONSTEXPR void sort(const Compare& compareFunction = Compare()) {
+			std::sort(this->begin(), this->end(), compareFunction);
+		}
+		
+		CONSTEXPR void sort(std::function<bool(Type&,Type&)> compareFunction) {
+			this->sort<std::function<bool(Type&,Type&)>>(compareFunction);
 		}
 		
-		CONSTEXPR Array sorted(std::function<bool(Type&,Type&)> compareFunction = std::less_equal<Type>()) const {
+		template <typename Compare = std::less<Type>>
+		CONSTEXPR Array sorted(const Compare& compareFunction = Compare()) const {
 			
 			if (this->isEmpty()) {
 				return *this;
@@ -1038,14 +1492,58 @@ namespace evt {
 			return otherArray;
 		}
 		
+		CONSTEXPR Array sorted(std::function<bool(Type&,Type&)> compareFunction) const {
+			return this->sorted<std::function<bool(Type&,Type&)>>(compareFunction);
+		}
+		
+		/// Sorts the chunks in parallel and merges them in pairs, also in parallel
+		template <typename Compare = std::less<Type>>
+		void parallelSort(const Compare& compareFunction = Compare(), ThreadPool& pool = ThreadPool::shared()) {
+			
+			const SizeType chunkSize = pool.chunkSizeFor(count_, elementsPerParallelChunk);
+			
+			pool.parallelFor(count_, elementsPerParallelChunk, [&](const SizeType first, const SizeType last) {
+				std::sort(this->begin() + first, this->begin() + last, compareFunction);
+			});
+			
+			for (SizeType sortedSize = chunkSize; sortedSize < count_; sortedSize *= 2) {
+				
+				const SizeType pairsCount = (count_ + 2 * sortedSize - 1) / (2 * sortedSize);
+				
+				pool.parallelFor(pairsCount, 1, [&](const SizeType firstPair, const SizeType lastPair) {
+					for (SizeType pair = firstPair; pair < lastPair; ++pair) {
+						const SizeType first = pair * 2 * sortedSize;
+						const SizeType middle = std::min(count_, first + sortedSize);
+						const SizeType last = std::min(count_, first + 2 * sortedSize);
+						std::inplace_merge(this->begin() + first, this->begin() + middle, this->begin() + last, compareFunction);
+					}
+				});
+			}
+		}
+		
+		void parallelSort(std::function<bool(const Type&, const Type&)> compareFunction, ThreadPool& pool = ThreadPool::shared()) {
+			this->parallelSort<std::function<bool(const Type&, const Type&)>>(compareFunction, pool);
+		}
+		
+		template <typename Compare = std::less<Type>>
+		Array parallelSorted(const Compare& compareFunction = Compare(), ThreadPool& pool = ThreadPool::shared()) const {
+			Array otherArray(*this);
+			otherArray.parallelSort(compareFunction, pool);
+			return otherArray;
+		}
+		
+		Array parallelSorted(std::function<bool(const Type&, const Type&)> compareFunction, ThreadPool& pool = ThreadPool::shared()) const {
+			return this->parallelSorted<std::function<bool(const Type&, const Type&)>>(compareFunction, pool);
+		}
+		
 		// MARK: Positions
 		
 		CONSTEXPR Type* begin() const {
-			return values.begin();
+			return values.data();
 		}
 		
 		CONSTEXPR Type* end() const {
-			return &values[count_];
+			return values.data() + count_;
 		}
 		
 		CONSTEXPR Type& first() {
@@ -1068,6 +1566,10 @@ namespace evt {
 			return values[count_-1];
 		}
 	};
+	
+	/// Array that keeps up to InlineCapacity elements without using the heap
+	template <typename Type, std::size_t InlineCapacity, typename Allocator = evt::DefaultAllocator, typename GrowthPolicy = evt::DefaultGrowth>
+	using SmallArray = Array<Type, Allocator, InlineCapacity, GrowthPolicy>;
 }
 
 #undef CONSTEXPR
@@ -0,0 +1,577 @@
+/*
+ The MIT License (MIT)
+ 
+ Copyright (c) 2017 Daniel Illescas Romero <https://github.com/illescasDaniel>
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#pragma once
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "EVTThreadPool.hpp"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+	#include <linux/io_uring.h>
+	#include <sys/mman.h>
+	#include <sys/syscall.h>
+	#define EVT_ASYNC_IO_URING 1
+#endif
+
+#if __cplusplus >= 202002L && __has_include(<coroutine>)
+	#include <coroutine>
+	#define EVT_ASYNC_COROUTINES 1
+#endif
+
+/*
+ Asynchronous reads and writes at file offsets. On Linux they go through io_uring, so many of them
+ can be in flight with a single thread; elsewhere (or if the kernel doesn't allow io_uring) a pool of
+ threads runs blocking pread/pwrite calls.
+
+ Example:
+	
+	evt::AsyncFile file("data.bin");
+	
+	auto header = file.readAsync(headerBuffer, 4096, 0);             // std::future<std::size_t>
+	file.readAsync(pageBuffer, 4096, offset, [](std::size_t bytes, int error) { ... });
+	std::size_t bytes = co_await file.readAwaitable(pageBuffer, 4096, offset); // C++20
+
+ Completions run on an internal thread, so they should be short, not block and not throw
+ (with the thread pool an exception is reported and ignored, with io_uring it ends the program).
+ */
+
+namespace evt {
+	
+	class AsyncIO {
+	
+	public:
+		
+		enum class Backend {
+			ioUring,
+			threadPool
+		};
+		
+		/// Bytes transferred and 0, or 0 and the errno of the failure
+		typedef std::function<void(std::size_t bytes, int error)> Completion;
+	
+	private:
+		
+		struct Operation {
+			bool isWrite;
+			int fileDescriptor;
+			struct iovec buffer;
+			std::uint64_t offset;
+			Completion completion;
+		};
+		
+		unsigned queueDepth_;
+		Backend backend_ {Backend::threadPool};
+		std::unique_ptr<ThreadPool> blockingThreads;
+		
+		static void complete(Operation* operation, const long result) {
+			const std::unique_ptr<Operation> completedOperation(operation);
+			if (result < 0) {
+				operation->completion(0, int(-result));
+			} else {
+				operation->completion(std::size_t(result), 0);
+			}
+		}
+		
+		void runBlocking(Operation* operation) {
+			blockingThreads->execute([operation] {
+				
+				ssize_t result;
+				do {
+					result = operation->isWrite
+						? ::pwrite(operation->fileDescriptor, operation->buffer.iov_base, operation->buffer.iov_len, off_t(operation->offset))
+						: ::pread(operation->fileDescriptor, operation->buffer.iov_base, operation->buffer.iov_len, off_t(operation->offset));
+				} while (result == -1 && errno == EINTR);
+				
+				complete(operation, (result == -1) ? -long(errno) : long(result));
+			});
+		}
+		
+		#if defined(EVT_ASYNC_IO_URING)
+		
+		int ringDescriptor {-1};
+		
+		void* submissionRing {nullptr};
+		std::size_t submissionRingSize {0};
+		void* completionRing {nullptr};
+		std::size_t completionRingSize {0};
+		struct io_uring_sqe* submissionEntries {nullptr};
+		std::size_t submissionEntriesSize {0};
+		
+		unsigned* submissionTail {nullptr};
+		unsigned submissionMask {0};
+		unsigned* submissionArray {nullptr};
+		unsigned* completionHead {nullptr};
+		unsigned* completionTail {nullptr};
+		unsigned completionMask {0};
+		struct io_uring_cqe* completionEntries {nullptr};
+		
+		// Operations wait here while the ring is full, so submitting never blocks
+		std::mutex submissionMutex;
+		std::deque<Operation*> waitingOperations;
+		unsigned operationsInFlight {0};
+		unsigned ringCapacity {0};
+		std::thread completionThread;
+		
+		template <typename Pointer>
+		Pointer ringField(void* ring, const unsigned offset) noexcept {
+			return reinterpret_cast<Pointer>(static_cast<char*>(ring) + offset);
+		}
+		
+		bool setUpRing() {
+			
+			struct io_uring_params parameters;
+			std::memset(&parameters, 0, sizeof(parameters));
+			
+			ringDescriptor = int(syscall(__NR_io_uring_setup, queueDepth_, &parameters));
+			if (ringDescriptor < 0) {
+				ringDescriptor = -1;
+				return false;
+			}
+			
+			submissionRingSize = parameters.sq_off.array + parameters.sq_entries * sizeof(unsigned);
+			completionRingSize = parameters.cq_off.cqes + parameters.cq_entries * sizeof(struct io_uring_cqe);
+			submissionEntriesSize = parameters.sq_entries * sizeof(struct io_uring_sqe);
+			
+			const bool isSingleMapping = (parameters.features & IORING_FEAT_SINGLE_MMAP) != 0;
+			if (isSingleMapping) {
+				submissionRingSize = completionRingSize = std::max(submissionRingSize, completionRingSize);
+			}
+			
+			submissionRing = mmap(nullptr, submissionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringDescriptor, IORING_OFF_SQ_RING);
+			completionRing = isSingleMapping ? submissionRing : mmap(nullptr, completionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringDescriptor, IORING_OFF_CQ_RING);
+			void* entries = mmap(nullptr, submissionEntriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringDescriptor, IORING_OFF_SQES);
+			
+			if (submissionRing == MAP_FAILED || completionRing == MAP_FAILED || entries == MAP_FAILED) {
+				if (submissionRing != MAP_FAILED) { munmap(submissionRing, submissionRingSize); }
+				if (!isSingleMapping && completionRing != MAP_FAILED) { munmap(completionRing, completionRingSize); }
+				if (entries != MAP_FAILED) { munmap(entries, submissionEntriesSize); }
+				submissionRing = completionRing = nullptr;
+				::close(ringDescriptor);
+				ringDescriptor = -1;
+				return false;
+			}
+			
+			submissionEntries = static_cast<struct io_uring_sqe*>(entries);
+			submissionTail = ringField<unsigned*>(submissionRing, parameters.sq_off.tail);
+			submissionMask = *ringField<unsigned*>(submissionRing, parameters.sq_off.ring_mask);
+			submissionArray = ringField<unsigned*>(submissionRing, parameters.sq_off.array);
+			completionHead = ringField<unsigned*>(completionRing, parameters.cq_off.head);
+			completionTail = ringField<unsigned*>(completionRing, parameters.cq_off.tail);
+			completionMask = *ringField<unsigned*>(completionRing, parameters.cq_off.ring_mask);
+			completionEntries = ringField<struct io_uring_cqe*>(completionRing, parameters.cq_off.cqes);
+			
+			// The completion queue is at least as big, so it can't overflow
+			ringCapacity = parameters.sq_entries;
+			
+			completionThread = std::thread([this] { completionLoop(); });
+			return true;
+		}
+		
+		int enterRing(const unsigned submitCount, const unsigned waitCount, const unsigned flags) noexcept {
+			int result;
+			do {
+				result = int(syscall(__NR_io_uring_enter, ringDescriptor, submitCount, waitCount, flags, nullptr, 0));
+			} while (result == -1 && errno == EINTR);
+			return result;
+		}
+		
+		/// Called with submissionMutex locked. A null operation stops the completion thread.
+		/// Returns 0, or -errno if the kernel didn't take the operation (then the ring is left as it was)
+		int pushToRing(Operation* operation) {
+			
+			const unsigned tail = *submissionTail;
+			const unsigned index = tail & submissionMask;
+			struct io_uring_sqe& entry = submissionEntries[index];
+			
+			std::memset(&entry, 0, sizeof(entry));
+			entry.user_data = reinterpret_cast<std::uint64_t>(operation);
+			
+			if (operation == nullptr) {
+				entry.opcode = IORING_OP_NOP;
+			} else {
+				entry.opcode = operation->isWrite ? IORING_OP_WRITEV : IORING_OP_READV;
+				entry.fd = operation->fileDescriptor;
+				entry.addr = reinterpret_cast<std::uint64_t>(&operation->buffer);
+				entry.len = 1;
+				entry.off = operation->offset;
+			}
+			
+			submissionArray[index] = index;
+			__atomic_store_n(submissionTail, tail + 1, __ATOMIC_RELEASE);
+			
+			// The kernel can refuse it for a while (EAGAIN, EBUSY, ENOMEM...), it must not stay in the ring to be sent with the next one
+			const int submitted = enterRing(1, 0, 0);
+			if (submitted < 1) {
+				const int error = (submitted < 0) ? errno : EAGAIN;
+				__atomic_store_n(submissionTail, tail, __ATOMIC_RELEASE);
+				return -error;
+			}
+			
+			operationsInFlight += 1;
+			return 0;
+		}
+		
+		void submitToRing(Operation* operation) {
+			
+			int result = 0;
+			{
+				std::lock_guard<std::mutex> lock(submissionMutex);
+				if (operationsInFlight < ringCapacity && waitingOperations.empty()) {
+					result = pushToRing(operation);
+				} else {
+					waitingOperations.push_back(operation);
+				}
+			}
+			
+			// Completed without the lock, the completion may submit other operations
+			if (result < 0) {
+				complete(operation, result);
+			}
+		}
+		
+		void completionLoop() {
+			
+			bool isStopping = false;
+			bool isIdle = false;
+			
+			// Completions don't come in order, the loop ends once the stop operation and all the others are done
+			while (!(isStopping && isIdle)) {
+				
+				unsigned head = *completionHead;
+				const unsigned tail = __atomic_load_n(completionTail, __ATOMIC_ACQUIRE);
+				
+				if (head == tail) {
+					enterRing(0, 1, IORING_ENTER_GETEVENTS);
+					continue;
+				}
+				
+				// Taking the lock also makes the operations written by the submitting threads visible here
+				std::deque<std::pair<Operation*, int>> failedOperations;
+				{
+					std::lock_guard<std::mutex> lock(submissionMutex);
+					operationsInFlight -= (tail - head);
+					
+					while (!waitingOperations.empty() && operationsInFlight < ringCapacity) {
+						
+						Operation* operation = waitingOperations.front();
+						waitingOperations.pop_front();
+						
+						const int result = pushToRing(operation);
+						if (result < 0) {
+							// The stop operation only marks the end, the ones before it are already pushed or failed
+							if (operation == nullptr) {
+								isStopping = true;
+							} else {
+								failedOperations.emplace_back(operation, result);
+							}
+						}
+					}
+					isIdle = (operationsInFlight == 0 && waitingOperations.empty());
+				}
+				
+				for (const auto& failedOperation: failedOperations) {
+					complete(failedOperation.first, failedOperation.second);
+				}
+				
+				for (; head != tail; ++head) {
+					
+					const struct io_uring_cqe& entry = completionEntries[head & completionMask];
+					Operation* operation = reinterpret_cast<Operation*>(entry.user_data);
+					const long result = entry.res;
+					
+					__atomic_store_n(completionHead, head + 1, __ATOMIC_RELEASE);
+					
+					if (operation == nullptr) {
+						isStopping = true;
+					} else {
+						complete(operation, result);
+					}
+				}
+			}
+		}
+		
+		void tearDownRing() {
+			
+			// The stop operation is queued after the waiting ones, so they all complete first.
+			// The completion thread may be waiting for it in the kernel, so it's tried again until the kernel takes it
+			while (true) {
+				{
+					std::lock_guard<std::mutex> lock(submissionMutex);
+					if (!(operationsInFlight < ringCapacity && waitingOperations.empty())) {
+						waitingOperations.push_back(nullptr);
+						break;
+					}
+					if (pushToRing(nullptr) == 0) {
+						break;
+					}
+				}
+				std::this_thread::yield();
+			}
+			completionThread.join();
+			
+			munmap(submissionEntries, submissionEntriesSize);
+			if (completionRing != submissionRing) {
+				munmap(completionRing, completionRingSize);
+			}
+			munmap(submissionRing, submissionRingSize);
+			::close(ringDescriptor);
+		}
+		
+		#endif
+		
+		void submit(const bool isWrite, const int fileDescriptor, const void* buffer, const std::size_t size, const std::uint64_t offset, Completion&& completion) {
+			
+			Operation* operation = new Operation {isWrite, fileDescriptor, {const_cast<void*>(buffer), size}, offset, std::move(completion)};
+			
+			#if defined(EVT_ASYNC_IO_URING)
+				if (backend_ == Backend::ioUring) {
+					submitToRing(operation);
+					return;
+				}
+			#endif
+			
+			runBlocking(operation);
+		}
+		
+		template <typename Function>
+		static std::future<std::size_t> futureFor(const Function& submitWithCompletion) {
+			
+			std::shared_ptr<std::promise<std::size_t>> promise = std::make_shared<std::promise<std::size_t>>();
+			std::future<std::size_t> future = promise->get_future();
+			
+			submitWithCompletion([promise](const std::size_t bytes, const int error) {
+				if (error != 0) {
+					promise->set_exception(std::make_exception_ptr(std::system_error(error, std::generic_category())));
+				} else {
+					promise->set_value(bytes);
+				}
+			});
+			
+			return future;
+		}
+	
+	public:
+		
+		/// Up to queueDepth operations are sent to the kernel at once (more wait in a queue).
+		/// Without io_uring (or with preferIoUring false) queueDepth threads run them.
+		explicit AsyncIO(const unsigned queueDepth = 64, const bool preferIoUring = true): queueDepth_(queueDepth > 0 ? queueDepth : 1) {
+			
+			#if defined(EVT_ASYNC_IO_URING)
+				if (preferIoUring && setUpRing()) {
+					backend_ = Backend::ioUring;
+					return;
+				}
+			#else
+				(void)preferIoUring;
+			#endif
+			
+			blockingThreads.reset(new ThreadPool(queueDepth_ + 1));
+		}
+		
+		AsyncIO(const AsyncIO&) = delete;
+		AsyncIO& operator=(const AsyncIO&) = delete;
+		
+		/// Engine used by default, created on first use
+		static AsyncIO& shared() {
+			static AsyncIO sharedEngine;
+			return sharedEngine;
+		}
+		
+		Backend backend() const noexcept {
+			return backend_;
+		}
+		
+		unsigned queueDepth() const noexcept {
+			return queueDepth_;
+		}
+		
+		// The buffers must stay alive until the operation completes
+		
+		void read(const int fileDescriptor, void* buffer, const std::size_t size, const std::uint64_t offset, Completion completion) {
+			submit(false, fileDescriptor, buffer, size, offset, std::move(completion));
+		}
+		
+		void write(const int fileDescriptor, const void* buffer, const std::size_t size, const std::uint64_t offset, Completion completion) {
+			submit(true, fileDescriptor, buffer, size, offset, std::move(completion));
+		}
+		
+		/// The future throws std::system_error if the read fails
+		std::future<std::size_t> read(const int fileDescriptor, void* buffer, const std::size_t size, const std::uint64_t offset) {
+			return futureFor([&](Completion&& completion) { this->read(fileDescriptor, buffer, size, offset, std::move(completion)); });
+		}
+		
+		std::future<std::size_t> write(const int fileDescriptor, const void* buffer, const std::size_t size, const std::uint64_t offset) {
+			return futureFor([&](Completion&& completion) { this->write(fileDescriptor, buffer, size, offset, std::move(completion)); });
+		}
+		
+		#if defined(EVT_ASYNC_COROUTINES)
+		
+		/// co_await gives the bytes transferred (or throws std::system_error), the coroutine resumes on the completion thread
+		class Awaitable {
+			
+			AsyncIO& engine;
+			bool isWrite;
+			int fileDescriptor;
+			const void* buffer;
+			std::size_t size;
+			std::uint64_t offset;
+			std::size_t bytes {0};
+			int error {0};
+		
+		public:
+			
+			Awaitable(AsyncIO& engine, const bool isWrite, const int fileDescriptor, const void* buffer, const std::size_t size, const std::uint64_t offset) noexcept
+			: engine(engine), isWrite(isWrite), fileDescriptor(fileDescriptor), buffer(buffer), size(size), offset(offset) {}
+			
+			bool await_ready() const noexcept { return false; }
+			
+			void await_suspend(std::coroutine_handle<> coroutine) {
+				engine.submit(isWrite, fileDescriptor, buffer, size, offset, [this, coroutine](const std::size_t bytes, const int error) {
+					this->bytes = bytes;
+					this->error = error;
+					coroutine.resume();
+				});
+			}
+			
+			std::size_t await_resume() const {
+				if (error != 0) {
+					throw std::system_error(error, std::generic_category());
+				}
+				return bytes;
+			}
+		};
+		
+		Awaitable readAwaitable(const int fileDescriptor, void* buffer, const std::size_t size, const std::uint64_t offset) noexcept {
+			return Awaitable(*this, false, fileDescriptor, buffer, size, offset);
+		}
+		
+		Awaitable writeAwaitable(const int fileDescriptor, const void* buffer, const std::size_t size, const std::uint64_t offset) noexcept {
+			return Awaitable(*this, true, fileDescriptor, buffer, size, offset);
+		}
+		
+		#endif
+		
+		/// Waits for the operations already submitted
+		~AsyncIO() {
+			#if defined(EVT_ASYNC_IO_URING)
+				if (backend_ == Backend::ioUring) {
+					tearDownRing();
+				}
+			#endif
+		}
+	};
+	
+	/// File opened for asynchronous reads and writes at offsets, see AsyncIO
+	class AsyncFile {
+		
+		int fileDescriptor {-1};
+		AsyncIO* engine;
+	
+	public:
+		
+		enum Access {
+			readOnly,
+			readWrite
+		};
+		
+		AsyncFile(const std::string& fileName, const Access access = Access::readOnly, AsyncIO& engine = AsyncIO::shared()): engine(&engine) {
+			
+			fileDescriptor = ::open(fileName.c_str(), (access == Access::readOnly) ? O_RDONLY : (O_RDWR | O_CREAT), 0644);
+			
+			if (fileDescriptor == -1) {
+				std::cerr << "File couldn't be open" << std::endl;
+			}
+		}
+		
+		AsyncFile(AsyncFile&& other) noexcept: fileDescriptor(other.fileDescriptor), engine(other.engine) {
+			other.fileDescriptor = -1;
+		}
+		
+		AsyncFile(const AsyncFile&) = delete;
+		AsyncFile& operator=(const AsyncFile&) = delete;
+		AsyncFile& operator=(AsyncFile&&) = delete;
+		
+		bool isOpen() const noexcept {
+			return fileDescriptor != -1;
+		}
+		
+		std::future<std::size_t> readAsync(void* buffer, const std::size_t size, const std::uint64_t offset) {
+			return engine->read(fileDescriptor, buffer, size, offset);
+		}
+		
+		void readAsync(void* buffer, const std::size_t size, const std::uint64_t offset, AsyncIO::Completion completion) {
+			engine->read(fileDescriptor, buffer, size, offset, std::move(completion));
+		}
+		
+		std::future<std::size_t> writeAsync(const void* buffer, const std::size_t size, const std::uint64_t offset) {
+			return engine->write(fileDescriptor, buffer, size, offset);
+		}
+		
+		void writeAsync(const void* buffer, const std::size_t size, const std::uint64_t offset, AsyncIO::Completion completion) {
+			engine->write(fileDescriptor, buffer, size, offset, std::move(completion));
+		}
+		
+		#if defined(EVT_ASYNC_COROUTINES)
+		
+		AsyncIO::Awaitable readAwaitable(void* buffer, const std::size_t size, const std::uint64_t offset) noexcept {
+			return engine->readAwaitable(fileDescriptor, buffer, size, offset);
+		}
+		
+		AsyncIO::Awaitable writeAwaitable(const void* buffer, const std::size_t size, const std::uint64_t offset) noexcept {
+			return engine->writeAwaitable(fileDescriptor, buffer, size, offset);
+		}
+		
+		#endif
+		
+		/// The operations in flight must be finished
+		~AsyncFile() {
+			if (fileDescriptor != -1) {
+				::close(fileDescriptor);
+			}
+		}
+	};
+}
+
+#undef EVT_ASYNC_IO_URING
+#undef EVT_ASYNC_COROUTINES
+
+#endif
@@ -0,0 +1,735 @@
+/*
+ The MIT License (MIT)
+ 
+ Copyright (c) 2017 Daniel Illescas Romero <https://github.com/illescasDaniel>
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <streambuf>
+#include <string>
+
+#if defined(EVT_USE_ZLIB)
+	#include <zlib.h>
+#endif
+
+#if defined(EVT_USE_ZSTD)
+	#include <zstd.h>
+#endif
+
+#if defined(EVT_USE_LZ4)
+	#include <lz4frame.h>
+#endif
+
+/*
+ Streaming compression for File, FileLines and FileWriter. Each codec needs its library, so it's only
+ compiled if it's requested before including the EVT headers:
+	
+	#define EVT_USE_ZLIB // gzip (.gz), link with -lz
+	#define EVT_USE_ZSTD // zstd (.zst), link with -lzstd
+	#define EVT_USE_LZ4  // lz4 frames (.lz4), link with -llz4
+
+ Compressed files are read and written sequentially. Writing at the end of a compressed file adds a new
+ frame, and consecutive frames are read as a single stream (like gzip, zstd and lz4 do).
+
+ Example:
+	
+	evt::File log("server.log.zst"); // Compression::automatic chooses zstd by the extension
+	log.write("Started\n");
+	for (const StringView line: log.lines()) { ... }
+ */
+
+namespace evt {
+	
+	enum class Compression {
+		none,
+		automatic, // By the extension of the file: .gz, .zst or .lz4 (if its codec is compiled)
+		gzip,
+		zstd,
+		lz4
+	};
+	
+	/// Whether the codec has been compiled, see EVT_USE_ZLIB, EVT_USE_ZSTD and EVT_USE_LZ4
+	inline bool isAvailable(const Compression compression) noexcept {
+		switch (compression) {
+			case Compression::none: return true;
+			case Compression::automatic: return true;
+			#if defined(EVT_USE_ZLIB)
+			case Compression::gzip: return true;
+			#endif
+			#if defined(EVT_USE_ZSTD)
+			case Compression::zstd: return true;
+			#endif
+			#if defined(EVT_USE_LZ4)
+			case Compression::lz4: return true;
+			#endif
+			default: return false;
+		}
+	}
+	
+	/// The given compression, or with automatic the one of the file extension.
+	/// It may not be available (see isAvailable), the files then report an error instead of using the raw bytes
+	inline Compression compressionOf(const std::string& fileName, const Compression compression) noexcept {
+		
+		if (compression != Compression::automatic) { return compression; }
+		
+		const auto hasExtension = [&fileName](const std::string& extension) {
+			return fileName.size() > extension.size() && fileName.compare(fileName.size() - extension.size(), extension.size(), extension) == 0;
+		};
+		
+		Compression byExtension = Compression::none;
+		
+		if (hasExtension(".gz")) { byExtension = Compression::gzip; }
+		else if (hasExtension(".zst")) { byExtension = Compression::zstd; }
+		else if (hasExtension(".lz4")) { byExtension = Compression::lz4; }
+		
+		return byExtension;
+	}
+	
+	/// Compresses a stream of bytes. The compressed bytes are given to a sink, which returns false if they can't be written.
+	class Compressor {
+	
+	public:
+		
+		typedef std::function<bool(const char* bytes, std::size_t count)> Sink;
+		
+		virtual ~Compressor() {}
+		
+		virtual bool compress(const char* bytes, std::size_t count, const Sink& sink) = 0;
+		
+		/// Sends everything compressed until now, so it can be decompressed (it makes the compression a bit worse)
+		virtual bool flush(const Sink& sink) = 0;
+		
+		/// Ends the frame, the next bytes start a new one
+		virtual bool finish(const Sink& sink) = 0;
+		
+		/// nullptr if the codec isn't compiled
+		static std::unique_ptr<Compressor> make(Compression compression);
+	};
+	
+	/// Decompresses a stream of bytes read from a source, which returns 0 at the end of the data
+	class Decompressor {
+	
+	protected:
+		
+		static constexpr std::size_t inputSize = 128 * 1024;
+		
+		std::unique_ptr<char[]> input {new char[inputSize]};
+		bool hasFailed {false};
+		bool hasPendingOutput {false}; // The last call filled the output, the codec may have more
+	
+	public:
+		
+		typedef std::function<std::size_t(char* bytes, std::size_t count)> Source;
+		
+		virtual ~Decompressor() {}
+		
+		/// Fills the bytes with up to count decompressed bytes, there are fewer only at the end of the data
+		virtual std::size_t decompress(char* bytes, std::size_t count, const Source& source) = 0;
+		
+		/// True if the data is corrupted or it ends in the middle of a frame
+		bool failed() const noexcept {
+			return hasFailed;
+		}
+		
+		/// nullptr if the codec isn't compiled
+		static std::unique_ptr<Decompressor> make(Compression compression);
+	};
+	
+	#if defined(EVT_USE_ZLIB)
+	
+	class GzipCompressor: public Compressor {
+		
+		static constexpr std::size_t outputSize = 128 * 1024;
+		
+		z_stream stream {};
+		std::unique_ptr<char[]> output {new char[outputSize]};
+		bool isFrameStarted {false};
+		
+		bool run(const int flushMode, const Sink& sink) {
+			
+			int result;
+			
+			do {
+				stream.next_out = reinterpret_cast<Bytef*>(output.get());
+				stream.avail_out = uInt(outputSize);
+				
+				result = deflate(&stream, flushMode);
+				if (result == Z_STREAM_ERROR) { return false; }
+				
+				const std::size_t compressedCount = outputSize - stream.avail_out;
+				if (compressedCount > 0 && !sink(output.get(), compressedCount)) { return false; }
+			
+			} while (stream.avail_out == 0 || (flushMode == Z_FINISH && result != Z_STREAM_END));
+			
+			return true;
+		}
+	
+	public:
+		
+		GzipCompressor() {
+			// 15 + 16: the biggest window with a gzip header
+			if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+				throw std::bad_alloc();
+			}
+		}
+		
+		GzipCompressor(const GzipCompressor&) = delete;
+		GzipCompressor& operator=(const GzipCompressor&) = delete;
+		
+		bool compress(const char* bytes, std::size_t count, const Sink& sink) override {
+			
+			isFrameStarted = isFrameStarted || count > 0;
+			
+			// avail_in is 32 bits
+			while (count > 0) {
+				
+				const std::size_t partCount = std::min(count, std::size_t(1) << 30);
+				stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(bytes));
+				stream.avail_in = uInt(partCount);
+				
+				if (!run(Z_NO_FLUSH, sink)) { return false; }
+				
+				bytes += partCount;
+				count -= partCount;
+			}
+			
+			return true;
+		}
+		
+		bool flush(const Sink& sink) override {
+			return !isFrameStarted || run(Z_SYNC_FLUSH, sink);
+		}
+		
+		bool finish(const Sink& sink) override {
+			
+			if (!isFrameStarted) { return true; }
+			
+			const bool isFinished = run(Z_FINISH, sink);
+			deflateReset(&stream);
+			isFrameStarted = false;
+			
+			return isFinished;
+		}
+		
+		~GzipCompressor() {
+			deflateEnd(&stream);
+		}
+	};
+	
+	class GzipDecompressor: public Decompressor {
+		
+		z_stream stream {};
+		bool isInFrame {false};
+	
+	public:
+		
+		GzipDecompressor() {
+			// 15 + 32: any window, gzip or zlib header
+			if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+				throw std::bad_alloc();
+			}
+		}
+		
+		GzipDecompressor(const GzipDecompressor&) = delete;
+		GzipDecompressor& operator=(const GzipDecompressor&) = delete;
+		
+		std::size_t decompress(char* bytes, std::size_t count, const Source& source) override {
+			
+			if (hasFailed) { return 0; }
+			
+			stream.next_out = reinterpret_cast<Bytef*>(bytes);
+			stream.avail_out = uInt(std::min(count, std::size_t(1) << 30));
+			const std::size_t outputCount = stream.avail_out;
+			
+			while (stream.avail_out > 0) {
+				
+				if (stream.avail_in == 0 && !hasPendingOutput) {
+					stream.next_in = reinterpret_cast<Bytef*>(input.get());
+					stream.avail_in = uInt(source(input.get(), inputSize));
+					if (stream.avail_in == 0) {
+						hasFailed = isInFrame;
+						break;
+					}
+				}
+				
+				const uInt previousInputCount = stream.avail_in;
+				const uInt previousOutputCount = stream.avail_out;
+				const int result = inflate(&stream, Z_NO_FLUSH);
+				const bool hasProgressed = (stream.avail_in < previousInputCount || stream.avail_out < previousOutputCount);
+				
+				hasPendingOutput = (stream.avail_out == 0) || (hasPendingOutput && hasProgressed);
+				
+				if (result == Z_STREAM_END) {
+					inflateReset(&stream);
+					isInFrame = false;
+					continue;
+				}
+				if (result != Z_OK && result != Z_BUF_ERROR) {
+					hasFailed = true;
+					break;
+				}
+				
+				isInFrame = isInFrame || hasProgressed;
+			}
+			
+			return outputCount - stream.avail_out;
+		}
+		
+		~GzipDecompressor() {
+			inflateEnd(&stream);
+		}
+	};
+	
+	#endif
+	
+	#if defined(EVT_USE_ZSTD)
+	
+	class ZstdCompressor: public Compressor {
+		
+		ZSTD_CCtx* context;
+		std::size_t outputSize {ZSTD_CStreamOutSize()};
+		std::unique_ptr<char[]> output {new char[outputSize]};
+		
+		bool run(ZSTD_inBuffer& inputBuffer, const ZSTD_EndDirective mode, const Sink& sink) {
+			while (true) {
+				
+				ZSTD_outBuffer outputBuffer {output.get(), outputSize, 0};
+				const std::size_t remaining = ZSTD_compressStream2(context, &outputBuffer, &inputBuffer, mode);
+				
+				if (ZSTD_isError(remaining)) { return false; }
+				if (outputBuffer.pos > 0 && !sink(output.get(), outputBuffer.pos)) { return false; }
+				
+				const bool isDone = (mode == ZSTD_e_continue) ? (inputBuffer.pos == inputBuffer.size) : (remaining == 0);
+				if (isDone) { return true; }
+			}
+		}
+	
+	public:
+		
+		ZstdCompressor(): context(ZSTD_createCCtx()) {
+			if (context == nullptr) { throw std::bad_alloc(); }
+		}
+		
+		ZstdCompressor(const ZstdCompressor&) = delete;
+		ZstdCompressor& operator=(const ZstdCompressor&) = delete;
+		
+		bool compress(const char* bytes, const std::size_t count, const Sink& sink) override {
+			ZSTD_inBuffer inputBuffer {bytes, count, 0};
+			return run(inputBuffer, ZSTD_e_continue, sink);
+		}
+		
+		bool flush(const Sink& sink) override {
+			ZSTD_inBuffer inputBuffer {nullptr, 0, 0};
+			return run(inputBuffer, ZSTD_e_flush, sink);
+		}
+		
+		/// Without new bytes since the last frame it doesn't write anything
+		bool finish(const Sink& sink) override {
+			ZSTD_inBuffer inputBuffer {nullptr, 0, 0};
+			return run(inputBuffer, ZSTD_e_end, sink);
+		}
+		
+		~ZstdCompressor() {
+			ZSTD_freeCCtx(context);
+		}
+	};
+	
+	class ZstdDecompressor: public Decompressor {
+		
+		ZSTD_DCtx* context;
+		ZSTD_inBuffer inputBuffer {nullptr, 0, 0};
+		bool isFrameComplete {true};
+	
+	public:
+		
+		ZstdDecompressor(): context(ZSTD_createDCtx()) {
+			if (context == nullptr) { throw std::bad_alloc(); }
+		}
+		
+		ZstdDecompressor(const ZstdDecompressor&) = delete;
+		ZstdDecompressor& operator=(const ZstdDecompressor&) = delete;
+		
+		std::size_t decompress(char* bytes, const std::size_t count, const Source& source) override {
+			
+			if (hasFailed) { return 0; }
+			
+			ZSTD_outBuffer outputBuffer {bytes, count, 0};
+			
+			while (outputBuffer.pos < outputBuffer.size) {
+				
+				if (inputBuffer.pos == inputBuffer.size && !hasPendingOutput) {
+					inputBuffer = ZSTD_inBuffer {input.get(), source(input.get(), inputSize), 0};
+					if (inputBuffer.size == 0) {
+						hasFailed = !isFrameComplete;
+						break;
+					}
+				}
+				
+				const std::size_t previousOutputPosition = outputBuffer.pos;
+				const std::size_t previousInputPosition = inputBuffer.pos;
+				const std::size_t result = ZSTD_decompressStream(context, &outputBuffer, &inputBuffer);
+				
+				if (ZSTD_isError(result)) {
+					hasFailed = true;
+					break;
+				}
+				
+				// A call without progress after the end of a frame asks for the next one
+				if (outputBuffer.pos > previousOutputPosition || inputBuffer.pos > previousInputPosition) {
+					isFrameComplete = (result == 0);
+				}
+				hasPendingOutput = (outputBuffer.pos == outputBuffer.size) || (hasPendingOutput && outputBuffer.pos > previousOutputPosition);
+			}
+			
+			return outputBuffer.pos;
+		}
+		
+		~ZstdDecompressor() {
+			ZSTD_freeDCtx(context);
+		}
+	};
+	
+	#endif
+	
+	#if defined(EVT_USE_LZ4)
+	
+	class Lz4Compressor: public Compressor {
+		
+		static constexpr std::size_t partSize = 64 * 1024;
+		
+		LZ4F_cctx* context {nullptr};
+		LZ4F_preferences_t preferences {};
+		std::size_t outputSize;
+		std::unique_ptr<char[]> output;
+		bool isFrameStarted {false};
+		
+		bool send(const std::size_t result, const Sink& sink) {
+			if (LZ4F_isError(result)) { return false; }
+			return result == 0 || sink(output.get(), result);
+		}
+	
+	public:
+		
+		Lz4Compressor()
+		: outputSize(std::max(LZ4F_compressBound(partSize, &preferences), std::size_t(LZ4F_HEADER_SIZE_MAX))), output(new char[outputSize]) {
+			if (LZ4F_isError(LZ4F_createCompressionContext(&context, LZ4F_VERSION))) {
+				throw std::bad_alloc();
+			}
+		}
+		
+		Lz4Compressor(const Lz4Compressor&) = delete;
+		Lz4Compressor& operator=(const Lz4Compressor&) = delete;
+		
+		bool compress(const char* bytes, std::size_t count, const Sink& sink) override {
+			
+			if (count > 0 && !isFrameStarted) {
+				if (!send(LZ4F_compressBegin(context, output.get(), outputSize, &preferences), sink)) { return false; }
+				isFrameStarted = true;
+			}
+			
+			// The output is big enough for partSize bytes
+			while (count > 0) {
+				
+				const std::size_t partCount = (count < partSize) ? count : partSize;
+				if (!send(LZ4F_compressUpdate(context, output.get(), outputSize, bytes, partCount, nullptr), sink)) { return false; }
+				
+				bytes += partCount;
+				count -= partCount;
+			}
+			
+			return true;
+		}
+		
+		bool flush(const Sink& sink) override {
+			return !isFrameStarted || send(LZ4F_flush(context, output.get(), outputSize, nullptr), sink);
+		}
+		
+		bool finish(const Sink& sink) override {
+			
+			if (!isFrameStarted) { return true; }
+			
+			isFrameStarted = false;
+			return send(LZ4F_compressEnd(context, output.get(), outputSize, nullptr), sink);
+		}
+		
+		~Lz4Compressor() {
+			LZ4F_freeCompressionContext(context);
+		}
+	};
+	
+	class Lz4Decompressor: public Decompressor {
+		
+		LZ4F_dctx* context {nullptr};
+		std::size_t inputPosition {0};
+		std::size_t inputCount {0};
+		bool isFrameComplete {true};
+	
+	public:
+		
+		Lz4Decompressor() {
+			if (LZ4F_isError(LZ4F_createDecompressionContext(&context, LZ4F_VERSION))) {
+				throw std::bad_alloc();
+			}
+		}
+		
+		Lz4Decompressor(const Lz4Decompressor&) = delete;
+		Lz4Decompressor& operator=(const Lz4Decompressor&) = delete;
+		
+		std::size_t decompress(char* bytes, const std::size_t count, const Source& source) override {
+			
+			if (hasFailed) { return 0; }
+			
+			std::size_t outputCount = 0;
+			
+			while (outputCount < count) {
+				
+				if (inputPosition == inputCount && !hasPendingOutput) {
+					inputPosition = 0;
+					inputCount = source(input.get(), inputSize);
+					if (inputCount == 0) {
+						hasFailed = !isFrameComplete;
+						break;
+					}
+				}
+				
+				std::size_t decompressedCount = count - outputCount;
+				std::size_t consumedCount = inputCount - inputPosition;
+				const std::size_t result = LZ4F_decompress(context, bytes + outputCount, &decompressedCount, input.get() + inputPosition, &consumedCount, nullptr);
+				
+				if (LZ4F_isError(result)) {
+					hasFailed = true;
+					break;
+				}
+				
+				inputPosition += consumedCount;
+				outputCount += decompressedCount;
+				if (decompressedCount > 0 || consumedCount > 0) {
+					isFrameComplete = (result == 0);
+				}
+				hasPendingOutput = (outputCount == count) || (hasPendingOutput && decompressedCount > 0);
+			}
+			
+			return outputCount;
+		}
+		
+		~Lz4Decompressor() {
+			LZ4F_freeDecompressionContext(context);
+		}
+	};
+	
+	#endif
+	
+	inline std::unique_ptr<Compressor> Compressor::make(const Compression compression) {
+		switch (compression) {
+			#if defined(EVT_USE_ZLIB)
+			case Compression::gzip: return std::unique_ptr<Compressor>(new GzipCompressor());
+			#endif
+			#if defined(EVT_USE_ZSTD)
+			case Compression::zstd: return std::unique_ptr<Compressor>(new ZstdCompressor());
+			#endif
+			#if defined(EVT_USE_LZ4)
+			case Compression::lz4: return std::unique_ptr<Compressor>(new Lz4Compressor());
+			#endif
+			default: return nullptr;
+		}
+	}
+	
+	inline std::unique_ptr<Decompressor> Decompressor::make(const Compression compression) {
+		switch (compression) {
+			#if defined(EVT_USE_ZLIB)
+			case Compression::gzip: return std::unique_ptr<Decompressor>(new GzipDecompressor());
+			#endif
+			#if defined(EVT_USE_ZSTD)
+			case Compression::zstd: return std::unique_ptr<Decompressor>(new ZstdDecompressor());
+			#endif
+			#if defined(EVT_USE_LZ4)
+			case Compression::lz4: return std::unique_ptr<Decompressor>(new Lz4Decompressor());
+			#endif
+			default: return nullptr;
+		}
+	}
+	
+	/// Stream buffer that compresses what is written into another stream buffer (the file), or decompresses what is read from it.
+	/// It only goes in one direction, and when reading it can only move forward.
+	class CompressedStreamBuffer: public std::streambuf {
+		
+		std::streambuf* file;
+		std::unique_ptr<Compressor> compressor;
+		std::unique_ptr<Decompressor> decompressor;
+		std::unique_ptr<char[]> buffer;
+		std::size_t bufferSize;
+		std::streamoff bufferPosition {0}; // Uncompressed position of the start of the buffer
+		bool hasReportedFailure {false};
+		
+		Compressor::Sink fileSink() {
+			return [this](const char* bytes, const std::size_t count) {
+				return file->sputn(bytes, std::streamsize(count)) == std::streamsize(count);
+			};
+		}
+		
+		bool sendBuffer() {
+			
+			const std::size_t count = std::size_t(pptr() - pbase());
+			bufferPosition += std::streamoff(count);
+			setp(buffer.get(), buffer.get() + bufferSize);
+			
+			return compressor->compress(buffer.get(), count, fileSink());
+		}
+	
+	protected:
+		
+		int_type underflow() override {
+			
+			if (!decompressor) { return traits_type::eof(); }
+			
+			bufferPosition += std::streamoff(egptr() - eback());
+			
+			const std::size_t count = decompressor->decompress(buffer.get(), bufferSize, [this](char* bytes, const std::size_t count) {
+				return std::size_t(file->sgetn(bytes, std::streamsize(count)));
+			});
+			setg(buffer.get(), buffer.get(), buffer.get() + count);
+			
+			if (decompressor->failed() && !hasReportedFailure) {
+				std::cerr << "Error: Corrupted compressed file" << std::endl;
+				hasReportedFailure = true;
+			}
+			
+			return (count > 0) ? traits_type::to_int_type(*gptr()) : traits_type::eof();
+		}
+		
+		int_type overflow(const int_type character) override {
+			
+			if (!compressor || !sendBuffer()) { return traits_type::eof(); }
+			
+			if (!traits_type::eq_int_type(character, traits_type::eof())) {
+				*pptr() = traits_type::to_char_type(character);
+				pbump(1);
+			}
+			
+			return traits_type::not_eof(character);
+		}
+		
+		/// Big writes are compressed directly, without copying them to the buffer
+		std::streamsize xsputn(const char* bytes, const std::streamsize count) override {
+			
+			if (!compressor) { return 0; }
+			
+			if (count > epptr() - pptr()) {
+				
+				if (!sendBuffer()) { return 0; }
+				
+				if (std::size_t(count) >= bufferSize) {
+					bufferPosition += count;
+					return compressor->compress(bytes, std::size_t(count), fileSink()) ? count : 0;
+				}
+			}
+			
+			std::memcpy(pptr(), bytes, std::size_t(count));
+			pbump(int(count));
+			
+			return count;
+		}
+		
+		int sync() override {
+			
+			if (!compressor) { return 0; }
+			
+			return (sendBuffer() && compressor->flush(fileSink()) && file->pubsync() == 0) ? 0 : -1;
+		}
+		
+		/// Writing is always at the end, so only the position can be asked. Reading can skip bytes forward.
+		pos_type seekoff(const off_type offset, const std::ios_base::seekdir direction, const std::ios_base::openmode) override {
+			
+			if (compressor) {
+				if (offset == 0 && direction != std::ios_base::beg) {
+					return pos_type(bufferPosition + (pptr() - pbase()));
+				}
+				return pos_type(off_type(-1));
+			}
+			
+			off_type position = bufferPosition + (gptr() - eback());
+			
+			if (direction == std::ios_base::end) { return pos_type(off_type(-1)); }
+			
+			const off_type target = (direction == std::ios_base::beg) ? offset : (position + offset);
+			if (target < position) { return pos_type(off_type(-1)); }
+			
+			while (position < target) {
+				
+				if (gptr() == egptr() && traits_type::eq_int_type(underflow(), traits_type::eof())) {
+					return pos_type(off_type(-1));
+				}
+				
+				const off_type skipped = std::min(off_type(egptr() - gptr()), target - position);
+				gbump(int(skipped));
+				position += skipped;
+			}
+			
+			return pos_type(position);
+		}
+		
+		pos_type seekpos(const pos_type position, const std::ios_base::openmode which) override {
+			return seekoff(off_type(position), std::ios_base::beg, which);
+		}
+	
+	public:
+		
+		/// The codec has to be available (see isAvailable)
+		CompressedStreamBuffer(std::streambuf* file, const Compression compression, const bool isWriting, const std::size_t bufferSize = 128 * 1024)
+		: file(file), buffer(new char[bufferSize > 0 ? bufferSize : 1]), bufferSize(bufferSize > 0 ? bufferSize : 1) {
+			
+			if (isWriting) {
+				compressor = Compressor::make(compression);
+				setp(buffer.get(), buffer.get() + this->bufferSize);
+			} else {
+				decompressor = Decompressor::make(compression);
+				setg(buffer.get(), buffer.get(), buffer.get());
+			}
+		}
+		
+		CompressedStreamBuffer(const CompressedStreamBuffer&) = delete;
+		CompressedStreamBuffer& operator=(const CompressedStreamBuffer&) = delete;
+		
+		bool isWriting() const noexcept {
+			return compressor != nullptr;
+		}
+		
+		/// When the file stream is moved, the new one has to be used
+		void setFile(std::streambuf* file) noexcept {
+			this->file = file;
+		}
+		
+		/// Compresses the buffered bytes and ends the frame (the file isn't flushed).
+		/// It has to be called before closing the file, a frame without end can't be read.
+		bool finish() {
+			return !compressor || (sendBuffer() && compressor->finish(fileSink()));
+		}
+	};
+}
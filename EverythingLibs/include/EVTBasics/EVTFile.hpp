@@ -25,8 +25,37 @@
 #pragma once
 
 #include <fstream>
+#include <iostream>
+#include <memory>
 #include <string>
+#include <stdexcept>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <type_traits>
+#include <iterator>
+#include <cstdint>
+#include <limits>
+#include <atomic>
+#include <mutex>
 #include "../EVTBasics/EVTOptional.hpp"
+#include "EVTArray.hpp"
+#include "EVTCompression.hpp"
+
+#if __cplusplus >= 201703L && __has_include(<string_view>)
+	#include "EVTStringView.hpp"
+	#define EVT_FILE_STRING_VIEW 1
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <sys/uio.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include "EVTAsyncIO.hpp"
+	#define EVT_FILE_POSIX 1
+#endif
 
 #if (__cplusplus > 201103L)
 #define CONSTEXPR constexpr
@@ -36,6 +65,644 @@
 
 namespace evt {
 	
+	/// How a mapped file is going to be read, the OS uses it to choose the read ahead
+	enum class AccessPattern {
+		normal,
+		sequential, // Reads ahead aggressively and drops the pages already read
+		random,     // Doesn't read ahead
+		willNeed    // Starts loading the whole mapping now
+	};
+	
+	/// Read only view of a file (or a window of it) in memory, without copying it.
+	/// The OS loads the pages when they are read. Where mmap isn't available the content is read once.
+	class MappedFile {
+		
+		const char* data_ {nullptr};
+		std::size_t size_ {0};
+		
+		void* mapping {nullptr};
+		std::size_t mappingSize {0};
+		std::string readContent;
+		
+		void unmap() noexcept {
+			#if defined(EVT_FILE_POSIX)
+				if (mapping != nullptr) {
+					munmap(mapping, mappingSize);
+				}
+			#endif
+			mapping = nullptr;
+			mappingSize = 0;
+		}
+		
+		void moveFrom(MappedFile& other) noexcept {
+			
+			mapping = other.mapping;
+			mappingSize = other.mappingSize;
+			readContent = std::move(other.readContent);
+			size_ = other.size_;
+			data_ = (mapping != nullptr || size_ == 0) ? other.data_ : readContent.data();
+			
+			other.mapping = nullptr;
+			other.mappingSize = 0;
+			other.data_ = nullptr;
+			other.size_ = 0;
+		}
+		
+		#if defined(EVT_FILE_POSIX)
+		
+		void mapFile(const std::string& fileName, const AccessPattern accessPattern, const std::size_t offset, const std::size_t length) {
+			
+			const int fileDescriptor = ::open(fileName.c_str(), O_RDONLY);
+			if (fileDescriptor == -1) {
+				std::cerr << "File couldn't be open" << std::endl;
+				return;
+			}
+			
+			struct stat fileStatus;
+			if (fstat(fileDescriptor, &fileStatus) == -1) {
+				::close(fileDescriptor);
+				std::cerr << "File couldn't be open" << std::endl;
+				return;
+			}
+			
+			const std::size_t fileSize = std::size_t(fileStatus.st_size);
+			if (offset > fileSize) {
+				::close(fileDescriptor);
+				throw std::out_of_range("Offset out of range");
+			}
+			
+			size_ = (length < fileSize - offset) ? length : (fileSize - offset);
+			if (size_ == 0) {
+				::close(fileDescriptor);
+				return;
+			}
+			
+			// mmap offsets must be multiples of the page size
+			const std::size_t pageSize = std::size_t(sysconf(_SC_PAGESIZE));
+			const std::size_t mappingOffset = offset / pageSize * pageSize;
+			mappingSize = size_ + (offset - mappingOffset);
+			
+			mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fileDescriptor, off_t(mappingOffset));
+			::close(fileDescriptor);
+			
+			if (mapping == MAP_FAILED) {
+				mapping = nullptr;
+				mappingSize = 0;
+				size_ = 0;
+				std::cerr << "File couldn't be mapped" << std::endl;
+				return;
+			}
+			
+			data_ = static_cast<const char*>(mapping) + (offset - mappingOffset);
+			this->advise(accessPattern);
+		}
+		
+		#else
+		
+		void mapFile(const std::string& fileName, const AccessPattern, const std::size_t offset, const std::size_t length) {
+			
+			std::ifstream fileStream(fileName, std::ios::in | std::ios::binary | std::ios::ate);
+			if (fileStream.fail()) {
+				std::cerr << "File couldn't be open" << std::endl;
+				return;
+			}
+			
+			const std::size_t fileSize = std::size_t(fileStream.tellg());
+			if (offset > fileSize) {
+				throw std::out_of_range("Offset out of range");
+			}
+			
+			size_ = (length < fileSize - offset) ? length : (fileSize - offset);
+			readContent.resize(size_);
+			fileStream.seekg(offset);
+			fileStream.read(&readContent[0], size_);
+			data_ = readContent.data();
+		}
+		
+		#endif
+	
+	public:
+		
+		static constexpr std::size_t wholeFile = std::size_t(-1);
+		
+		MappedFile() noexcept {}
+		
+		/// Maps [offset, offset + length) of the file, the length is clamped to the end of the file
+		MappedFile(const std::string& fileName, const AccessPattern accessPattern = AccessPattern::sequential,
+				   const std::size_t offset = 0, const std::size_t length = wholeFile) {
+			mapFile(fileName, accessPattern, offset, length);
+		}
+		
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		
+		MappedFile(MappedFile&& other) noexcept {
+			moveFrom(other);
+		}
+		
+		MappedFile& operator=(MappedFile&& other) noexcept {
+			if (this != &other) {
+				unmap();
+				moveFrom(other);
+			}
+			return *this;
+		}
+		
+		/// Changes the read ahead of the OS for the mapping (does nothing without mmap)
+		void advise(const AccessPattern accessPattern) const noexcept {
+			
+			#if defined(EVT_FILE_POSIX)
+				if (mapping == nullptr) { return; }
+				
+				int advice = MADV_NORMAL;
+				switch (accessPattern) {
+					case AccessPattern::normal: advice = MADV_NORMAL; break;
+					case AccessPattern::sequential: advice = MADV_SEQUENTIAL; break;
+					case AccessPattern::random: advice = MADV_RANDOM; break;
+					case AccessPattern::willNeed: advice = MADV_WILLNEED; break;
+				}
+				madvise(mapping, mappingSize, advice);
+			#else
+				(void)accessPattern;
+			#endif
+		}
+		
+		const char* data() const noexcept { return data_; }
+		std::size_t size() const noexcept { return size_; }
+		std::size_t count() const noexcept { return size_; }
+		bool isEmpty() const noexcept { return size_ == 0; }
+		
+		const char* begin() const noexcept { return data_; }
+		const char* end() const noexcept { return data_ + size_; }
+		
+		const char& operator[](const std::size_t index) const {
+			if (index >= size_) {
+				throw std::out_of_range("Index out of range");
+			}
+			return data_[index];
+		}
+		
+		/// Copies the content
+		std::string toString() const {
+			return std::string(data_, size_);
+		}
+		
+		#if defined(EVT_FILE_STRING_VIEW)
+		StringView toStringView() const noexcept {
+			return StringView(data_, size_);
+		}
+		#endif
+		
+		~MappedFile() {
+			unmap();
+		}
+	};
+	
+	#if defined(EVT_FILE_STRING_VIEW)
+	
+	/// Lines of a file read in big blocks. Each line is a StringView into the internal buffer, so it's only
+	/// valid until the next line is read. The memory used is about the block size (or the longest line).
+	///
+	///		for (const StringView line: File("server.log").lines()) { ... }
+	class FileLines {
+		
+		std::ifstream fileStream;
+		std::unique_ptr<CompressedStreamBuffer> compressedBuffer;
+		std::unique_ptr<char[]> buffer;
+		std::size_t bufferSize {0};
+		
+		std::size_t lineStart {0};
+		std::size_t lineEnd {0};
+		std::size_t nextLineStart {0};
+		std::size_t dataEnd {0};
+		bool isFinished {false};
+		
+		/// Moves the incomplete line to the start of the buffer and reads after it, false at the end of the file
+		bool readBlock() {
+			
+			const std::size_t incompleteCount = dataEnd - lineStart;
+			std::memmove(buffer.get(), buffer.get() + lineStart, incompleteCount);
+			lineStart = 0;
+			dataEnd = incompleteCount;
+			
+			if (dataEnd == bufferSize) {
+				std::unique_ptr<char[]> newBuffer(new char[bufferSize * 2]);
+				std::memcpy(newBuffer.get(), buffer.get(), dataEnd);
+				buffer = std::move(newBuffer);
+				bufferSize *= 2;
+			}
+			
+			fileStream.read(buffer.get() + dataEnd, std::streamsize(bufferSize - dataEnd));
+			dataEnd += std::size_t(fileStream.gcount());
+			
+			return dataEnd > incompleteCount;
+		}
+		
+		void readLine() {
+			
+			lineStart = nextLineStart;
+			std::size_t searchStart = lineStart;
+			
+			while (true) {
+				
+				const void* newLine = std::memchr(buffer.get() + searchStart, '\n', dataEnd - searchStart);
+				
+				if (newLine != nullptr) {
+					lineEnd = std::size_t(static_cast<const char*>(newLine) - buffer.get());
+					nextLineStart = lineEnd + 1;
+					return;
+				}
+				
+				const std::size_t searchedCount = dataEnd - lineStart;
+				
+				if (!fileStream || !readBlock()) {
+					// The last line may not end with a new line
+					isFinished = (lineStart == dataEnd);
+					lineEnd = nextLineStart = dataEnd;
+					return;
+				}
+				
+				searchStart = lineStart + searchedCount;
+			}
+		}
+	
+	public:
+		
+		class Iterator {
+			
+			FileLines* lines;
+		
+		public:
+			
+			typedef std::input_iterator_tag iterator_category;
+			typedef StringView value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef const StringView* pointer;
+			typedef StringView reference;
+			
+			Iterator(FileLines* lines = nullptr) noexcept: lines(lines) {}
+			
+			StringView operator*() const noexcept {
+				return StringView(lines->buffer.get() + lines->lineStart, lines->lineEnd - lines->lineStart);
+			}
+			
+			Iterator& operator++() {
+				lines->readLine();
+				return *this;
+			}
+			
+			bool operator==(const Iterator& other) const noexcept {
+				const bool isEnd = (lines == nullptr || lines->isFinished);
+				const bool otherIsEnd = (other.lines == nullptr || other.lines->isFinished);
+				return (isEnd && otherIsEnd) || (!isEnd && !otherIsEnd && lines == other.lines);
+			}
+			
+			bool operator!=(const Iterator& other) const noexcept {
+				return !(*this == other);
+			}
+		};
+		
+		/// Compressed files are decompressed while they are read (see Compression)
+		FileLines(const std::string& fileName, const std::size_t blockSize = 1024 * 1024, const Compression compression = Compression::automatic)
+		: fileStream(fileName, std::ios::in | std::ios::binary), buffer(new char[blockSize > 0 ? blockSize : 1]), bufferSize(blockSize > 0 ? blockSize : 1) {
+			
+			if (fileStream.fail()) {
+				std::cerr << "File couldn't be open" << std::endl;
+				isFinished = true;
+				return;
+			}
+			
+			const Compression fileCompression = compressionOf(fileName, compression);
+			
+			if (fileCompression != Compression::none) {
+				
+				if (!isAvailable(fileCompression)) {
+					std::cerr << "Error: Compression not available" << std::endl;
+					isFinished = true;
+					return;
+				}
+				
+				compressedBuffer.reset(new CompressedStreamBuffer(fileStream.rdbuf(), fileCompression, false));
+				static_cast<std::ios&>(fileStream).rdbuf(compressedBuffer.get());
+			}
+			
+			readLine();
+		}
+		
+		FileLines(FileLines&& other) noexcept
+		: fileStream(std::move(other.fileStream)), compressedBuffer(std::move(other.compressedBuffer)), buffer(std::move(other.buffer)), bufferSize(other.bufferSize),
+		  lineStart(other.lineStart), lineEnd(other.lineEnd), nextLineStart(other.nextLineStart), dataEnd(other.dataEnd), isFinished(other.isFinished) {
+			
+			// The moved stream uses its own file buffer again
+			if (compressedBuffer) {
+				compressedBuffer->setFile(fileStream.rdbuf());
+				static_cast<std::ios&>(fileStream).rdbuf(compressedBuffer.get());
+			}
+		}
+		
+		/// Only one pass is possible, begin() continues from the current line
+		Iterator begin() noexcept { return Iterator(this); }
+		Iterator end() noexcept { return Iterator(); }
+	};
+	
+	#endif
+	
+	/// When a FileWriter waits for the data to reach the disk
+	enum class Durability {
+		none,        // The OS decides
+		syncOnFlush, // Every flush waits for the disk
+		syncOnClose  // Only closing (or destroying) the writer waits for the disk
+	};
+	
+	/// Writes to a file through a big buffer, the small writes are sent to the OS together in a single call.
+	/// The data is written when the buffer is full, on flush() and on close()/destruction.
+	class FileWriter {
+		
+		std::unique_ptr<char[]> buffer;
+		std::size_t bufferSize;
+		std::size_t bufferedCount {0};
+		Durability durability;
+		std::unique_ptr<Compressor> compressor;
+		bool hasCompressedData {false}; // Compressed since the last flush, it may be inside the compressor
+		bool hasFailed {false};
+		
+		#if defined(EVT_FILE_POSIX)
+		
+		int fileDescriptor {-1};
+		
+		bool isOpen() const noexcept { return fileDescriptor != -1; }
+		
+		void openFile(const std::string& fileName, const bool append) {
+			fileDescriptor = ::open(fileName.c_str(), O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC), 0644);
+			if (fileDescriptor == -1) {
+				std::cerr << "File couldn't be open" << std::endl;
+				hasFailed = true; // The writes are lost, failed() has to tell it
+			}
+		}
+		
+		/// Both groups of bytes, in a single writev when possible
+		void writeToFile(const char* firstBytes, const std::size_t firstCount, const char* secondBytes, const std::size_t secondCount) {
+			
+			struct iovec parts[2] = {{const_cast<char*>(firstBytes), firstCount}, {const_cast<char*>(secondBytes), secondCount}};
+			struct iovec* part = parts;
+			int partCount = 2;
+			
+			while (partCount > 0) {
+				
+				const ssize_t written = ::writev(fileDescriptor, part, partCount);
+				
+				if (written == -1) {
+					if (errno == EINTR) { continue; }
+					reportFailure();
+					return;
+				}
+				
+				// Partial writes continue where they stopped
+				std::size_t remaining = std::size_t(written);
+				while (partCount > 0 && remaining >= part->iov_len) {
+					remaining -= part->iov_len;
+					part += 1;
+					partCount -= 1;
+				}
+				if (partCount > 0) {
+					part->iov_base = static_cast<char*>(part->iov_base) + remaining;
+					part->iov_len -= remaining;
+				}
+			}
+		}
+		
+		void syncFile() {
+			#if defined(__APPLE__)
+				const int result = ::fsync(fileDescriptor);
+			#else
+				const int result = ::fdatasync(fileDescriptor);
+			#endif
+			if (result == -1) {
+				reportFailure();
+			}
+		}
+		
+		void closeFile() noexcept {
+			::close(fileDescriptor);
+			fileDescriptor = -1;
+		}
+		
+		void moveFileFrom(FileWriter& other) noexcept {
+			fileDescriptor = other.fileDescriptor;
+			other.fileDescriptor = -1;
+		}
+		
+		#else
+		
+		std::ofstream fileStream;
+		
+		bool isOpen() const noexcept { return fileStream.is_open(); }
+		
+		void openFile(const std::string& fileName, const bool append) {
+			fileStream.open(fileName, std::ios::binary | std::ios::out | (append ? std::ios::app : std::ios::trunc));
+			if (fileStream.fail()) {
+				std::cerr << "File couldn't be open" << std::endl;
+				hasFailed = true; // The writes are lost, failed() has to tell it
+			}
+		}
+		
+		void writeToFile(const char* firstBytes, const std::size_t firstCount, const char* secondBytes, const std::size_t secondCount) {
+			fileStream.write(firstBytes, std::streamsize(firstCount));
+			fileStream.write(secondBytes, std::streamsize(secondCount));
+			if (fileStream.fail()) {
+				reportFailure();
+			}
+		}
+		
+		void syncFile() {
+			fileStream.flush();
+		}
+		
+		void closeFile() noexcept {
+			fileStream.close();
+		}
+		
+		void moveFileFrom(FileWriter& other) noexcept {
+			fileStream = std::move(other.fileStream);
+		}
+		
+		#endif
+		
+		void reportFailure() {
+			if (!hasFailed) {
+				std::cerr << "File couldn't be written" << std::endl;
+			}
+			hasFailed = true;
+		}
+		
+		Compressor::Sink fileSink() {
+			return [this](const char* bytes, const std::size_t count) {
+				writeToFile(bytes, count, nullptr, 0);
+				return !hasFailed;
+			};
+		}
+		
+		/// The buffered bytes and then the given ones, compressed first if the file is compressed
+		void sendToFile(const char* bytes, const std::size_t count) {
+			
+			if (!compressor) {
+				writeToFile(buffer.get(), bufferedCount, bytes, count);
+				return;
+			}
+			
+			if (!compressor->compress(buffer.get(), bufferedCount, fileSink()) || !compressor->compress(bytes, count, fileSink())) {
+				reportFailure();
+			}
+			hasCompressedData = true;
+		}
+		
+		void writeBytes(const char* bytes, const std::size_t count) {
+			
+			if (bufferSize - bufferedCount >= count) {
+				std::memcpy(buffer.get() + bufferedCount, bytes, count);
+				bufferedCount += count;
+				return;
+			}
+			
+			if (!isOpen()) { return; }
+			
+			// Too big for the buffer, sent together with the buffered bytes
+			if (count >= bufferSize) {
+				sendToFile(bytes, count);
+				bufferedCount = 0;
+				return;
+			}
+			
+			sendToFile(nullptr, 0);
+			std::memcpy(buffer.get(), bytes, count);
+			bufferedCount = count;
+		}
+	
+	public:
+		
+		/// Compressed files are compressed while they are written, appending adds a new frame (see Compression)
+		FileWriter(const std::string& fileName, const std::size_t bufferSize = 1024 * 1024, const Durability durability = Durability::none,
+				   const bool append = true, const Compression compression = Compression::automatic)
+		: buffer(new char[bufferSize > 0 ? bufferSize : 1]), bufferSize(bufferSize > 0 ? bufferSize : 1), durability(durability) {
+			
+			const Compression fileCompression = compressionOf(fileName, compression);
+			
+			if (fileCompression != Compression::none) {
+				compressor = Compressor::make(fileCompression);
+				if (!compressor) {
+					std::cerr << "Error: Compression not available" << std::endl;
+					hasFailed = true;
+					return;
+				}
+			}
+			
+			openFile(fileName, append);
+		}
+		
+		FileWriter(FileWriter&& other) noexcept
+		: buffer(std::move(other.buffer)), bufferSize(other.bufferSize), bufferedCount(other.bufferedCount),
+		  durability(other.durability), compressor(std::move(other.compressor)), hasCompressedData(other.hasCompressedData), hasFailed(other.hasFailed) {
+			moveFileFrom(other);
+			other.bufferedCount = 0;
+		}
+		
+		FileWriter(const FileWriter&) = delete;
+		FileWriter& operator=(const FileWriter&) = delete;
+		FileWriter& operator=(FileWriter&&) = delete;
+		
+		void write(const char* text, const std::size_t count) {
+			writeBytes(text, count);
+		}
+		
+		void write(const std::string& text) {
+			writeBytes(text.data(), text.size());
+		}
+		
+		void write(const char* text) {
+			writeBytes(text, std::strlen(text));
+		}
+		
+		void write(const char character) {
+			writeBytes(&character, 1);
+		}
+		
+		/// Numbers are written like std::ostream does by default
+		template <typename Type, typename = typename std::enable_if<std::is_arithmetic<Type>::value>::type>
+		void write(const Type number) {
+			
+			char text[64];
+			int count = 0;
+			
+			if (std::is_floating_point<Type>::value) {
+				count = std::snprintf(text, sizeof(text), "%Lg", static_cast<long double>(number));
+			} else if (std::is_signed<Type>::value) {
+				count = std::snprintf(text, sizeof(text), "%lld", static_cast<long long>(number));
+			} else {
+				count = std::snprintf(text, sizeof(text), "%llu", static_cast<unsigned long long>(number));
+			}
+			
+			writeBytes(text, std::size_t(count));
+		}
+		
+		template <typename Type, typename = typename std::enable_if<!std::is_same<Type, std::string>::value>::type>
+		void writeInBinary(const Type& contentToWrite) {
+			static_assert(std::is_trivially_copyable<Type>::value, "Only trivially copyable types can be written in binary");
+			writeBytes(reinterpret_cast<const char*>(&contentToWrite), sizeof(contentToWrite));
+		}
+		
+		void writeInBinary(const std::string& text) {
+			writeBytes(text.data(), text.size());
+		}
+		
+		/// Sends the buffered data to the OS (and waits for the disk with Durability::syncOnFlush).
+		/// Compressed files can be decompressed up to here after it.
+		void flush() {
+			
+			if (!isOpen()) { return; }
+			
+			if (bufferedCount > 0) {
+				sendToFile(nullptr, 0);
+				bufferedCount = 0;
+			}
+			if (hasCompressedData && !compressor->flush(fileSink())) {
+				reportFailure();
+			}
+			hasCompressedData = false;
+			if (durability == Durability::syncOnFlush) {
+				syncFile();
+			}
+		}
+		
+		void close() {
+			
+			if (!isOpen()) { return; }
+			
+			if (compressor) {
+				sendToFile(nullptr, 0);
+				bufferedCount = 0;
+				if (!compressor->finish(fileSink())) {
+					reportFailure();
+				}
+				hasCompressedData = false;
+			}
+			
+			flush();
+			if (durability == Durability::syncOnClose) {
+				syncFile();
+			}
+			closeFile();
+		}
+		
+		/// True if some data couldn't be written
+		bool failed() const noexcept {
+			return hasFailed;
+		}
+		
+		~FileWriter() {
+			close();
+		}
+	};
+	
 	class File {
 		
 	public:
@@ -48,43 +715,383 @@ namespace evt {
 		
 	private:
 		
+		// The stream is opened once for reading and writing, switching between both only moves it
+		// to the position of the other one (saved in inputPosition and outputPosition)
+		enum class StreamUse {
+			none,
+			reading,
+			writing,
+			appending
+		};
+		
 		std::fstream fileStream;
-		std::ios_base::openmode inputOutputMode;
+		std::unique_ptr<CompressedStreamBuffer> compressedBuffer; // Used by fileStream instead of its file buffer
+		Compression compression_ {Compression::none};
+		std::ios_base::openmode openedStreamKind {};
+		StreamUse streamUse {StreamUse::none};
+		std::streampos inputPosition {0};
+		std::streampos outputPosition {0};
+		std::size_t openCount_ {0};
 		std::string fileName_;
 		Mode mode {Mode::both};
+		bool isSwappingArrayBytes {false};
+		
+		// readAt/writeAt don't use fileStream, so they can run in many threads without moving its position
+		#if defined(EVT_FILE_POSIX)
+		mutable std::atomic<int> positionalDescriptor {-1};
+		#else
+		mutable std::fstream positionalStream;
+		#endif
+		mutable std::mutex positionalMutex;
+		
+		/// Text and binary streams are only different outside POSIX (new line translation)
+		static std::ios_base::openmode streamKind(const std::ios_base::openmode inputOutputMode) noexcept {
+			#if defined(EVT_FILE_POSIX)
+				(void)inputOutputMode;
+				return std::ios::binary;
+			#else
+				return inputOutputMode & std::ios::binary;
+			#endif
+		}
+		
+		/// For reading and writing, or only for reading if the file can't be written.
+		/// Files that don't exist are created only when they are going to be written.
+		void openStream(const std::ios_base::openmode kind, const bool isWriting, const bool isTruncating) {
+			
+			closeStream();
+			
+			if (isTruncating) {
+				inputPosition = 0;
+				outputPosition = 0;
+			}
+			
+			if (compression_ != Compression::none) {
+				openCompressedStream(kind, isWriting, isTruncating);
+				return;
+			}
+			
+			fileStream.open(fileName_, kind | std::ios::in | std::ios::out | (isTruncating ? std::ios::trunc : std::ios::openmode()));
+			
+			if (!fileStream.is_open() && isWriting && !isTruncating) {
+				fileStream.clear();
+				fileStream.open(fileName_, kind | std::ios::in | std::ios::out | std::ios::trunc);
+			}
+			if (!fileStream.is_open() && !isWriting) {
+				fileStream.clear();
+				fileStream.open(fileName_, kind | std::ios::in);
+			}
+			
+			if (!fileStream.is_open()) {
+				std::cerr << "File couldn't be open" << std::endl;
+				return;
+			}
+			
+			openedStreamKind = kind;
+			openCount_ += 1;
+		}
+		
+		/// Compressed streams go in one direction: reading from the start, or writing a new frame at the end
+		void openCompressedStream(const std::ios_base::openmode kind, const bool isWriting, const bool isTruncating) {
+			
+			if (!isAvailable(compression_)) {
+				std::cerr << "Error: Compression not available" << std::endl;
+				return;
+			}
+			
+			fileStream.open(fileName_, std::ios::binary | (isWriting ? (std::ios::out | (isTruncating ? std::ios::trunc : std::ios::app)) : std::ios::in));
+			
+			if (!fileStream.is_open()) {
+				std::cerr << "File couldn't be open" << std::endl;
+				return;
+			}
+			
+			compressedBuffer.reset(new CompressedStreamBuffer(fileStream.rdbuf(), compression_, isWriting));
+			static_cast<std::ios&>(fileStream).rdbuf(compressedBuffer.get());
+			
+			openedStreamKind = kind;
+			openCount_ += 1;
+		}
+		
+		/// Keeps the position of the current use to go back to it later
+		void saveStreamPosition() {
+			
+			// An input that reached the end can still be moved (to write, or to read again after seekInputPosition)
+			fileStream.clear();
+			
+			if (streamUse == StreamUse::reading) {
+				inputPosition = fileStream.tellg();
+			} else if (streamUse == StreamUse::writing) {
+				outputPosition = fileStream.tellp();
+			}
+		}
 		
+		/// Opens the stream the first time (or when it has to be truncated), then moves it to the input or output position
 		void open(const std::ios_base::openmode inputOutputMode) {
 			
-			if (this->inputOutputMode != inputOutputMode) {
-				
-				close();
-				this->inputOutputMode = inputOutputMode;
-				fileStream.open(fileName_, inputOutputMode);
-				
-				if (fileStream.fail()) {
-					std::cerr << "File couldn't be open" << std::endl;
-				}
+			const bool isWriting = (inputOutputMode & std::ios::out) != 0;
+			const bool isTruncating = (inputOutputMode & std::ios::trunc) != 0;
+			const std::ios_base::openmode kind = streamKind(inputOutputMode);
+			
+			StreamUse newUse = !isWriting ? StreamUse::reading : ((inputOutputMode & std::ios::app) ? StreamUse::appending : StreamUse::writing);
+			if (compression_ != Compression::none && newUse == StreamUse::writing) {
+				newUse = StreamUse::appending;
+			}
+			
+			const bool needsOpening = !fileStream.is_open() || isTruncating || kind != openedStreamKind
+									  || (compressedBuffer && compressedBuffer->isWriting() != isWriting);
+			
+			if (newUse != streamUse || needsOpening) {
+				saveStreamPosition();
+			}
+			
+			if (needsOpening) {
+				openStream(kind, isWriting, isTruncating);
+				if (!fileStream.is_open()) { return; }
+			}
+			
+			if (newUse == streamUse) { return; }
+			
+			fileStream.clear();
+			
+			switch (newUse) {
+				case StreamUse::reading: fileStream.seekg(inputPosition); break;
+				case StreamUse::writing: fileStream.seekp(outputPosition); break;
+				case StreamUse::appending: fileStream.seekp(0, std::ios::end); break;
+				case StreamUse::none: break;
 			}
+			
+			streamUse = newUse;
 		}
 		
-		void close() {
+		void closeStream() {
+			
+			if (compressedBuffer) {
+				if (!compressedBuffer->finish()) {
+					std::cerr << "File couldn't be written" << std::endl;
+				}
+				static_cast<std::ios&>(fileStream).rdbuf(fileStream.rdbuf());
+				compressedBuffer.reset();
+			}
+			
 			if (fileStream.is_open()) {
 				fileStream.close();
 			}
+			fileStream.clear();
+			streamUse = StreamUse::none;
 		}
 		
-		void incompatibleMode() noexcept {
+		void close() {
+			closeStream();
+			inputPosition = 0;
+			outputPosition = 0;
+		}
+		
+		void incompatibleMode() const noexcept {
 			std::cerr << "Error: Incompatible Mode" << std::endl;
 		}
 		
+		/// Header written before the elements of writeArray (16 bytes)
+		struct ArrayHeader {
+			
+			static constexpr std::uint8_t currentVersion = 1;
+			static constexpr std::uint8_t littleEndian = 1;
+			static constexpr std::uint8_t bigEndian = 2;
+			
+			char magic[4];
+			std::uint8_t version;
+			std::uint8_t byteOrder;
+			std::uint16_t elementSize;
+			std::uint64_t count;
+			
+			static std::uint8_t hostByteOrder() noexcept {
+				const std::uint16_t one = 1;
+				return (*reinterpret_cast<const std::uint8_t*>(&one) == 1) ? littleEndian : bigEndian;
+			}
+		};
+		
+		template <typename Type>
+		static void reverseBytes(Type& value) noexcept {
+			std::uint8_t* bytes = reinterpret_cast<std::uint8_t*>(&value);
+			std::reverse(bytes, bytes + sizeof(Type));
+		}
+		
+		/// Bytes from the input position to the end of the file
+		std::size_t remainingInputBytes() {
+			
+			const std::streampos position = fileStream.tellg();
+			fileStream.seekg(0, std::ios::end);
+			const std::streampos end = fileStream.tellg();
+			fileStream.seekg(position);
+			
+			return (position >= 0 && end > position) ? std::size_t(end - position) : 0;
+		}
+		
+		/// Number of elements of the next array, 0 if it can't be read as an array of Type
+		template <typename Type>
+		std::size_t readArrayHeader() {
+			
+			if (mode == Mode::normal) { incompatibleMode(); return 0; }
+			
+			open(std::ios::in | std::ios::binary);
+			
+			ArrayHeader header {};
+			fileStream.read(reinterpret_cast<char*>(&header), sizeof(header));
+			
+			if (fileStream.gcount() != std::streamsize(sizeof(header)) || std::memcmp(header.magic, "EVTA", 4) != 0 || header.version != ArrayHeader::currentVersion) {
+				std::cerr << "Error: Not an array" << std::endl;
+				return 0;
+			}
+			
+			isSwappingArrayBytes = (header.byteOrder != ArrayHeader::hostByteOrder());
+			if (isSwappingArrayBytes) {
+				reverseBytes(header.elementSize);
+				reverseBytes(header.count);
+			}
+			
+			if (header.elementSize != sizeof(Type) || (isSwappingArrayBytes && sizeof(Type) > 1 && !std::is_arithmetic<Type>::value)) {
+				std::cerr << "Error: Incompatible array elements" << std::endl;
+				return 0;
+			}
+			
+			// A corrupt or truncated header can't make us reserve more than the file has (compressed files can't be checked before reading them)
+			if (header.count > std::numeric_limits<std::size_t>::max() / sizeof(Type)
+				|| (!compressedBuffer && header.count > remainingInputBytes() / sizeof(Type))) {
+				std::cerr << "Error: The array is bigger than the file" << std::endl;
+				return 0;
+			}
+			
+			return std::size_t(header.count);
+		}
+		
+		/// Reads the elements after the header in a single read, returns the elements read
+		template <typename Type>
+		std::size_t readArrayElements(Type* elements, const std::size_t count) {
+			
+			fileStream.read(reinterpret_cast<char*>(elements), std::streamsize(count * sizeof(Type)));
+			const std::size_t readCount = std::size_t(fileStream.gcount()) / sizeof(Type);
+			
+			if (isSwappingArrayBytes) {
+				for (std::size_t i = 0; i < readCount; i++) {
+					reverseBytes(elements[i]);
+				}
+			}
+			
+			return readCount;
+		}
+		
+		#if defined(EVT_FILE_POSIX)
+		
+		/// Descriptor for readAt/writeAt, opened on first use (read only if the file can't be written)
+		int positionalFile(const bool isWriting) const {
+			
+			int descriptor = positionalDescriptor.load(std::memory_order_acquire);
+			if (descriptor != -1) { return descriptor; }
+			
+			std::lock_guard<std::mutex> lock(positionalMutex);
+			descriptor = positionalDescriptor.load(std::memory_order_relaxed);
+			if (descriptor != -1) { return descriptor; }
+			
+			descriptor = ::open(fileName_.c_str(), O_RDWR | (isWriting ? O_CREAT : 0), 0644);
+			if (descriptor == -1 && !isWriting) {
+				descriptor = ::open(fileName_.c_str(), O_RDONLY);
+			}
+			
+			if (descriptor == -1) {
+				std::cerr << "File couldn't be open" << std::endl;
+			} else {
+				positionalDescriptor.store(descriptor, std::memory_order_release);
+			}
+			
+			return descriptor;
+		}
+		
+		void closePositionalFile() noexcept {
+			const int descriptor = positionalDescriptor.exchange(-1);
+			if (descriptor != -1) {
+				::close(descriptor);
+			}
+		}
+		
+		/// Whole transfer with pread/pwrite, continuing after partial transfers. Stops at the end of the file when reading.
+		std::size_t transferAt(const bool isWriting, const std::uint64_t offset, char* bytes, const std::size_t count) const {
+			
+			const int descriptor = positionalFile(isWriting);
+			if (descriptor == -1) { return 0; }
+			
+			std::size_t transferred = 0;
+			
+			while (transferred < count) {
+				
+				const ssize_t result = isWriting
+					? ::pwrite(descriptor, bytes + transferred, count - transferred, off_t(offset + transferred))
+					: ::pread(descriptor, bytes + transferred, count - transferred, off_t(offset + transferred));
+				
+				if (result == -1) {
+					if (errno == EINTR) { continue; }
+					std::cerr << (isWriting ? "File couldn't be written" : "File couldn't be read") << std::endl;
+					break;
+				}
+				if (result == 0) { break; }
+				
+				transferred += std::size_t(result);
+			}
+			
+			return transferred;
+		}
+		
+		#else
+		
+		void closePositionalFile() noexcept {
+			std::lock_guard<std::mutex> lock(positionalMutex);
+			positionalStream.close();
+		}
+		
+		/// Without pread/pwrite the transfers use their own stream, one at a time
+		std::size_t transferAt(const bool isWriting, const std::uint64_t offset, char* bytes, const std::size_t count) const {
+			
+			std::lock_guard<std::mutex> lock(positionalMutex);
+			
+			if (!positionalStream.is_open()) {
+				positionalStream.open(fileName_, std::ios::binary | std::ios::in | std::ios::out);
+				if (!positionalStream.is_open() && isWriting) {
+					positionalStream.open(fileName_, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+				}
+				if (!positionalStream.is_open()) {
+					positionalStream.clear();
+					positionalStream.open(fileName_, std::ios::binary | std::ios::in);
+				}
+				if (!positionalStream.is_open()) {
+					std::cerr << "File couldn't be open" << std::endl;
+					return 0;
+				}
+			}
+			
+			positionalStream.clear();
+			
+			if (isWriting) {
+				positionalStream.seekp(std::streamoff(offset));
+				positionalStream.write(bytes, std::streamsize(count));
+				positionalStream.flush();
+				return positionalStream.fail() ? 0 : count;
+			}
+			
+			positionalStream.seekg(std::streamoff(offset));
+			positionalStream.read(bytes, std::streamsize(count));
+			return std::size_t(positionalStream.gcount());
+		}
+		
+		#endif
+	
 	public:
 		
 		// Only for binary files
 		bool writeAtEnd = true;
 		
-		File(const std::string& fileName, const Mode mode = Mode::both) noexcept {
+		/// Compressed files are decompressed and compressed while they are read and written, see Compression
+		File(const std::string& fileName, const Mode mode = Mode::both, const Compression compression = Compression::automatic) noexcept {
 			this->fileName_ = fileName;
 			this->mode = mode;
+			this->compression_ = compressionOf(fileName, compression);
 		}
 		
 		/* BINARY */
@@ -123,24 +1130,165 @@ namespace evt {
 		template <typename Type, typename = typename std::enable_if<std::is_same<Type, std::string>::value>::type>
 		Type readFromBinary(std::size_t size) {
 			
-			if (mode == Mode::normal) { incompatibleMode(); return Type{}; }
+			Type text;
+			readFromBinary(text, size);
+			
+			return text;
+		}
+		
+		/// Reads up to size bytes, returns the bytes read
+		std::size_t readFromBinary(char* bytes, const std::size_t size) {
+			
+			if (mode == Mode::normal) { incompatibleMode(); return 0; }
 			
 			open(std::ios::in | std::ios::binary);
+			fileStream.read(bytes, std::streamsize(size));
+			
+			return std::size_t(fileStream.gcount());
+		}
+		
+		/// Replaces the text with up to size bytes and returns the bytes read.
+		/// Its memory is reused, so reading records in a loop with the same string doesn't allocate.
+		std::size_t readFromBinary(std::string& text, const std::size_t size) {
+			
+			text.resize(size);
+			const std::size_t readCount = readFromBinary(&text[0], size);
+			text.resize(readCount);
+			
+			return readCount;
+		}
+		
+		/// Replaces the bytes with up to size bytes read directly into the array memory, returns the bytes read
+		template <typename Allocator, std::size_t InlineCapacity, typename GrowthPolicy>
+		std::size_t readFromBinary(Array<char, Allocator, InlineCapacity, GrowthPolicy>& bytes, const std::size_t size) {
+			
+			bytes.clear();
+			
+			return bytes.appendUninitialized(size, [&](char* newBytes) {
+				return readFromBinary(newBytes, size);
+			});
+		}
+		
+		/* ARRAYS */
+		
+		/// Writes the elements in a single write, after a header with their size, count and byte order
+		template <typename Type>
+		void writeArray(const Type* elements, const std::size_t count) {
+			
+			static_assert(std::is_trivially_copyable<Type>::value, "Only trivially copyable types can be written in binary");
+			
+			if (mode == Mode::normal) { incompatibleMode(); return; }
+			
+			if (writeAtEnd) { open(std::ios::binary | std::ios::out | std::ios::in | std::ios::app);
+			} else { open(std::ios::binary | std::ios::out | std::ios::in); }
+			
+			const ArrayHeader header {{'E', 'V', 'T', 'A'}, ArrayHeader::currentVersion, ArrayHeader::hostByteOrder(), std::uint16_t(sizeof(Type)), std::uint64_t(count)};
+			fileStream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			fileStream.write(reinterpret_cast<const char*>(elements), std::streamsize(count * sizeof(Type)));
+		}
+		
+		template <typename Type, typename Allocator, std::size_t InlineCapacity, typename GrowthPolicy>
+		void writeArray(const Array<Type, Allocator, InlineCapacity, GrowthPolicy>& elements) {
+			writeArray(elements.begin(), elements.count());
+		}
+		
+		/// Reads an array written with writeArray into memory for up to maximumCount elements, returns the elements read.
+		/// The elements that don't fit are skipped.
+		template <typename Type>
+		std::size_t readArray(Type* elements, const std::size_t maximumCount) {
+			
+			const std::size_t count = readArrayHeader<Type>();
+			const std::size_t readCount = (count < maximumCount) ? count : maximumCount;
 			
-			std::unique_ptr<char> readTextChar(new char[size]);
-			fileStream.read(readTextChar.get(), size);
+			readArrayElements(elements, readCount);
+			fileStream.seekg(std::streamoff((count - readCount) * sizeof(Type)), std::ios::cur);
+			
+			return readCount;
+		}
+		
+		/// Appends the elements of an array written with writeArray, they are read directly into the array memory
+		template <typename Type, typename Allocator, std::size_t InlineCapacity, typename GrowthPolicy>
+		std::size_t readArray(Array<Type, Allocator, InlineCapacity, GrowthPolicy>& elements) {
+			
+			const std::size_t count = readArrayHeader<Type>();
+			
+			// The elements of a compressed file are read in chunks of 1MB, so the array only grows with the data that really is in the file
+			const std::size_t chunkCount = compressedBuffer ? std::max(std::size_t(1 << 20) / sizeof(Type), std::size_t(1)) : count;
+			std::size_t readCount = 0;
+			
+			while (readCount < count) {
+				
+				const std::size_t nextCount = std::min(chunkCount, count - readCount);
+				const std::size_t nextReadCount = elements.appendUninitialized(nextCount, [&](Type* newElements) {
+					return readArrayElements(newElements, nextCount);
+				});
+				
+				readCount += nextReadCount;
+				if (nextReadCount < nextCount) { break; }
+			}
 			
-			return readTextChar.get();
+			return readCount;
+		}
+		
+		template <typename Type>
+		Array<Type> readArray() {
+			Array<Type> elements;
+			readArray(elements);
+			return elements;
 		}
 		
 		void seekPosition(std::size_t offsetPosition, std::ios_base::seekdir position = std::ios::beg) {
 			
 			if (mode == Mode::normal) { incompatibleMode(); return; }
 			
+			if (compression_ != Compression::none) {
+				std::cerr << "Error: Compressed files can only be written at the end" << std::endl;
+				return;
+			}
+			
 			writeAtEnd = false;
+			open(std::ios::binary | std::ios::out | std::ios::in);
 			fileStream.seekp(offsetPosition, position);
 		}
 		
+		/* POSITIONAL */
+		
+		/// Reads up to count bytes at offset and returns the bytes read (fewer at the end of the file).
+		/// It doesn't use nor move the position of the stream functions, and many threads can read the same File at once.
+		/// Writes still buffered by the stream functions aren't seen, and compressed files are read as they are on disk.
+		std::size_t readAt(const std::uint64_t offset, void* buffer, const std::size_t count) const {
+			
+			if (mode == Mode::normal) { incompatibleMode(); return 0; }
+			
+			return transferAt(false, offset, static_cast<char*>(buffer), count);
+		}
+		
+		/// Reads a value at offset, false if the file ends before it
+		template <typename Type>
+		bool readAt(const std::uint64_t offset, Type& value) const {
+			static_assert(std::is_trivially_copyable<Type>::value, "Only trivially copyable types can be read in binary");
+			return readAt(offset, &value, sizeof(Type)) == sizeof(Type);
+		}
+		
+		/// Writes count bytes at offset (the file grows if needed) and returns the bytes written.
+		/// Like readAt, it doesn't move the stream position and it can be called from many threads.
+		std::size_t writeAt(const std::uint64_t offset, const void* data, const std::size_t count) {
+			
+			if (mode == Mode::normal) { incompatibleMode(); return 0; }
+			
+			return transferAt(true, offset, static_cast<char*>(const_cast<void*>(data)), count);
+		}
+		
+		bool writeAt(const std::uint64_t offset, const std::string& text) {
+			return writeAt(offset, text.data(), text.size()) == text.size();
+		}
+		
+		template <typename Type, typename = typename std::enable_if<!std::is_same<Type, std::string>::value>::type>
+		bool writeAt(const std::uint64_t offset, const Type& value) {
+			static_assert(std::is_trivially_copyable<Type>::value, "Only trivially copyable types can be written in binary");
+			return writeAt(offset, &value, sizeof(Type)) == sizeof(Type);
+		}
+		
 		/* TEXT */
 		
 		template <typename Type>
@@ -221,6 +1369,106 @@ namespace evt {
 			return outputContent;
 		}
 		
+		/// The content without copying it (compressed files as they are on disk), see MappedFile
+		MappedFile map(const AccessPattern accessPattern = AccessPattern::sequential,
+					   const std::size_t offset = 0, const std::size_t length = MappedFile::wholeFile) const {
+			return MappedFile(fileName_, accessPattern, offset, length);
+		}
+		
+		#if defined(EVT_FILE_STRING_VIEW)
+		/// Range of the lines of the file without allocating per line, see FileLines
+		FileLines lines(const std::size_t blockSize = 1024 * 1024) const {
+			return FileLines(fileName_, blockSize, compression_);
+		}
+		
+		/// Splits the mapped file in chunks that end in a new line and scans them in parallel: each chunk starts with a copy
+		/// of initialResult and calls scanLine(chunkResult, line) for its lines. The chunk results are merged in file order
+		/// with merge(result, std::move(chunkResult)), so the result doesn't depend on the threads.
+		///
+		///		auto errors = file.parallelScan(Array<std::string>(), [](Array<std::string>& errors, StringView line) {
+		///			if (line.contains("ERROR")) { errors.append(std::string(line)); }
+		///		});
+		template <typename Result, typename ScanLine, typename Merge>
+		Result parallelScan(Result initialResult, const ScanLine& scanLine, const Merge& merge,
+							ThreadPool& pool = ThreadPool::shared(), const std::size_t minimumChunkSize = 4 * 1024 * 1024) const {
+			
+			// Compressed files can only be decompressed in order, so their lines are scanned in this thread
+			if (compression_ != Compression::none) {
+				for (const StringView line: this->lines()) {
+					scanLine(initialResult, line);
+				}
+				return initialResult;
+			}
+			
+			const MappedFile content = this->map(AccessPattern::sequential);
+			const std::size_t size = content.size();
+			if (size == 0) { return initialResult; }
+			
+			// A few chunks per thread, so the ones with more work can be balanced
+			std::size_t chunkCount = std::min(pool.threadCount() * 4, (size + minimumChunkSize - 1) / std::max(minimumChunkSize, std::size_t(1)));
+			chunkCount = std::max(chunkCount, std::size_t(1));
+			
+			Array<std::size_t> chunkStarts(chunkCount + 1);
+			chunkStarts.append(0);
+			
+			for (std::size_t chunk = 1; chunk < chunkCount; chunk++) {
+				
+				const std::size_t searchStart = std::max(chunk * (size / chunkCount), chunkStarts.last() + 1) - 1;
+				const void* newLine = (searchStart < size) ? std::memchr(content.data() + searchStart, '\n', size - searchStart) : nullptr;
+				
+				chunkStarts.append(newLine ? std::size_t(static_cast<const char*>(newLine) - content.data()) + 1 : size);
+			}
+			chunkStarts.append(size);
+			
+			Array<Result> chunkResults(chunkCount);
+			for (std::size_t chunk = 0; chunk < chunkCount; chunk++) {
+				chunkResults.append(initialResult);
+			}
+			
+			pool.parallelFor(chunkCount, 1, [&](const std::size_t firstChunk, const std::size_t lastChunk) {
+				for (std::size_t chunk = firstChunk; chunk < lastChunk; chunk++) {
+					
+					const char* position = content.data() + chunkStarts[chunk];
+					const char* chunkEnd = content.data() + chunkStarts[chunk + 1];
+					
+					while (position < chunkEnd) {
+						const char* lineEnd = static_cast<const char*>(std::memchr(position, '\n', std::size_t(chunkEnd - position)));
+						if (lineEnd == nullptr) { lineEnd = chunkEnd; }
+						
+						scanLine(chunkResults[chunk], StringView(position, std::size_t(lineEnd - position)));
+						position = lineEnd + 1;
+					}
+				}
+			});
+			
+			for (Result& chunkResult: chunkResults) {
+				merge(initialResult, std::move(chunkResult));
+			}
+			
+			return initialResult;
+		}
+		
+		/// parallelScan merging the chunk results with +=
+		template <typename Result, typename ScanLine>
+		Result parallelScan(Result initialResult, const ScanLine& scanLine, ThreadPool& pool = ThreadPool::shared()) const {
+			return this->parallelScan(std::move(initialResult), scanLine, [](Result& result, Result&& chunkResult) {
+				result += std::move(chunkResult);
+			}, pool);
+		}
+		#endif
+		
+		/// Buffered writer for many small writes, see FileWriter
+		FileWriter writer(const std::size_t bufferSize = 1024 * 1024, const Durability durability = Durability::none, const bool append = true) const {
+			return FileWriter(fileName_, bufferSize, durability, append, compression_);
+		}
+		
+		#if defined(EVT_FILE_POSIX)
+		/// Opens the file again for asynchronous reads and writes at offsets, see AsyncFile
+		AsyncFile async(const AsyncFile::Access access = AsyncFile::readOnly, AsyncIO& engine = AsyncIO::shared()) const {
+			return AsyncFile(fileName_, access, engine);
+		}
+		#endif
+		
 		static std::string toString(const std::string& fileName) {
 			File fileToRead(fileName);
 			return fileToRead.toString();
@@ -228,20 +1476,31 @@ namespace evt {
 		
 		static void saveTextTo(const std::string& fileName, const std::string& text) {
 			File fileToWrite(fileName);
-			fileToWrite.open(std::ios::out);
+			fileToWrite.open(std::ios::out | std::ios::trunc);
 			fileToWrite.write(text);
 		}
 		
 		/* OTHER */
 		
 		void seekInputPosition(std::size_t offsetPosition, std::ios_base::seekdir position = std::ios::beg) {
+			open(std::ios::in | openedStreamKind);
+			fileStream.clear();
+			
+			// Compressed files are read forward, going back reads them again from the start
+			if (compressedBuffer && position == std::ios::beg && std::streamoff(offsetPosition) < std::streamoff(fileStream.tellg())) {
+				close();
+				open(std::ios::in | openedStreamKind);
+			}
+			
 			fileStream.seekg(offsetPosition, position);
 		}
 		
-		void open(const std::string& fileName, const Mode mode = Mode::both) {
+		void open(const std::string& fileName, const Mode mode = Mode::both, const Compression compression = Compression::automatic) {
+			this->close();
 			this->fileName_ = fileName;
 			this->mode = mode;
-			this->close();
+			this->compression_ = compressionOf(fileName, compression);
+			this->closePositionalFile();
 		}
 		
 		bool endOfFile() const {
@@ -252,10 +1511,18 @@ namespace evt {
 			return fileName_;
 		}
 		
+		/// Times the stream has been opened, it only happens again after open(fileName) or saveTextTo
+		std::size_t openCount() const noexcept {
+			return openCount_;
+		}
+		
 		~File() {
 			close();
+			closePositionalFile();
 		}
 	};
 }
 
 #undef CONSTEXPR
+#undef EVT_FILE_STRING_VIEW
+#undef EVT_FILE_POSIX
@@ -0,0 +1,112 @@
+/*
+ The MIT License (MIT)
+ 
+ Copyright (c) 2017 Daniel Illescas Romero <https://github.com/illescasDaniel>
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+
+/*
+ Growth policies decide the capacity of an Array when it grows and when it shrinks after a removal.
+ A policy is any class with:
+	
+	static std::size_t grownCapacity(std::size_t capacity, std::size_t minimumCapacity, std::size_t elementSize);
+	static std::size_t shrunkCapacity(std::size_t capacity, std::size_t count, std::size_t elementSize); // capacity to keep it
+
+ Example:
+	
+	evt::Array<Message, evt::DefaultAllocator, 0, evt::NeverShrinkGrowth> queue;
+ */
+
+namespace evt {
+	
+	enum class ShrinkMode {
+		hysteresis, // Below a quarter of the capacity, shrinks to twice the count (a push/pop around the limit doesn't reallocate)
+		never
+	};
+	
+	enum class CapacityRounding {
+		none,
+		sizeClass, // Power of two bytes up to 64KiB (like SizeClassPool and most mallocs), multiples of 4KiB after that
+		pages      // Multiples of 4KiB from 4KiB on
+	};
+	
+	/// Capacity multiplied by Numerator/Denominator on each growth
+	template <std::size_t Numerator = 2, std::size_t Denominator = 1,
+			  ShrinkMode shrinkMode = ShrinkMode::hysteresis,
+			  CapacityRounding rounding = CapacityRounding::none>
+	struct GrowthPolicy {
+		
+		static_assert(Numerator > Denominator && Denominator > 0, "The growth factor must be bigger than 1");
+		
+		static constexpr std::size_t pageSize = 4096;
+		static constexpr std::size_t biggestSizeClass = 64 * 1024;
+		
+		static std::size_t roundedCapacity(const std::size_t capacity, const std::size_t elementSize) noexcept {
+			
+			const std::size_t bytes = capacity * elementSize;
+			std::size_t roundedBytes = bytes;
+			
+			if (rounding == CapacityRounding::sizeClass && bytes <= biggestSizeClass) {
+				roundedBytes = 16;
+				while (roundedBytes < bytes) {
+					roundedBytes *= 2;
+				}
+			}
+			else if (rounding == CapacityRounding::sizeClass || (rounding == CapacityRounding::pages && bytes >= pageSize)) {
+				roundedBytes = (bytes + pageSize - 1) / pageSize * pageSize;
+			}
+			
+			const std::size_t newCapacity = roundedBytes / elementSize;
+			return (newCapacity > capacity) ? newCapacity : capacity;
+		}
+		
+		static std::size_t grownCapacity(const std::size_t capacity, const std::size_t minimumCapacity, const std::size_t elementSize) noexcept {
+			
+			std::size_t newCapacity = capacity / Denominator * Numerator + capacity % Denominator * Numerator / Denominator;
+			if (newCapacity <= capacity) { newCapacity = capacity + 1; }
+			if (newCapacity < minimumCapacity) { newCapacity = minimumCapacity; }
+			
+			return roundedCapacity(newCapacity, elementSize);
+		}
+		
+		static std::size_t shrunkCapacity(const std::size_t capacity, const std::size_t count, const std::size_t elementSize) noexcept {
+			
+			if (shrinkMode == ShrinkMode::never || count >= capacity / 4) {
+				return capacity;
+			}
+			
+			const std::size_t newCapacity = roundedCapacity((count > 0) ? (count * 2) : 1, elementSize);
+			return (newCapacity < capacity) ? newCapacity : capacity;
+		}
+	};
+	
+	typedef GrowthPolicy<2, 1> DoublingGrowth;
+	typedef GrowthPolicy<3, 2> OneAndHalfGrowth;
+	typedef GrowthPolicy<2, 1, ShrinkMode::hysteresis, CapacityRounding::sizeClass> SizeClassGrowth;
+	typedef GrowthPolicy<2, 1, ShrinkMode::hysteresis, CapacityRounding::pages> PageRoundedGrowth;
+	typedef GrowthPolicy<2, 1, ShrinkMode::never> NeverShrinkGrowth;
+	
+	typedef DoublingGrowth DefaultGrowth;
+}
@@ -0,0 +1,365 @@
+/*
+ The MIT License (MIT)
+ 
+ Copyright (c) 2017 Daniel Illescas Romero <https://github.com/illescasDaniel>
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include "EVTAllocator.hpp"
+#include "EVTGrowthPolicy.hpp"
+#include "EVTOptional.hpp"
+
+/*
+ Lazy views over an Array. The stages are fused: each element goes through the whole pipeline
+ before the next one is read, and nothing is allocated until a terminal function
+ (toArray, reduce, forEach, count, first) is called.
+
+ Example:
+	
+	auto errorLines = lines.lazy()
+		.filter([](const std::string& line) { return line.find("ERROR") != std::string::npos; })
+		.map([](const std::string& line) { return line.substr(20); })
+		.take(100)
+		.toArray();
+
+ The view only points to the array (and to the containers passed to zip), so they must outlive it.
+ */
+
+namespace evt {
+	
+	template <typename Type, typename Allocator, std::size_t InlineCapacity, typename GrowthPolicy>
+	class Array;
+	
+	namespace internalEVT {
+		
+		/// Type stored by toArray for the values of a view (references and pairs of references are copied)
+		template <typename Value>
+		struct LazyElement { typedef typename std::decay<Value>::type type; };
+		
+		template <typename First, typename Second>
+		struct LazyElement<std::pair<First, Second>> {
+			typedef std::pair<typename std::decay<First>::type, typename std::decay<Second>::type> type;
+		};
+		
+		// Every stage has a "Value" type and a run(consumer) function that passes its values to consumer
+		// until it returns false. run returns false if it was stopped.
+		
+		template <typename Type>
+		class LazyArraySource {
+			const Type* first;
+			const Type* last;
+		public:
+			typedef const Type& Value;
+			
+			LazyArraySource(const Type* first, const Type* last): first(first), last(last) {}
+			
+			template <typename Consumer>
+			bool run(Consumer& consumer) const {
+				for (const Type* element = first; element != last; ++element) {
+					if (!consumer(*element)) { return false; }
+				}
+				return true;
+			}
+		};
+		
+		template <typename Source, typename Function>
+		class LazyFilter {
+			Source source;
+			Function function;
+		public:
+			typedef typename Source::Value Value;
+			
+			LazyFilter(const Source& source, const Function& function): source(source), function(function) {}
+			
+			template <typename Consumer>
+			bool run(Consumer& consumer) const {
+				auto filter = [&](Value value) {
+					return function(value) ? consumer(std::forward<Value>(value)) : true;
+				};
+				return source.run(filter);
+			}
+		};
+		
+		template <typename Source, typename Function>
+		class LazyMap {
+			Source source;
+			Function function;
+		public:
+			typedef typename std::decay<decltype(std::declval<const Function&>()(std::declval<typename Source::Value>()))>::type Value;
+			
+			LazyMap(const Source& source, const Function& function): source(source), function(function) {}
+			
+			template <typename Consumer>
+			bool run(Consumer& consumer) const {
+				auto map = [&](typename Source::Value value) {
+					return consumer(function(std::forward<typename Source::Value>(value)));
+				};
+				return source.run(map);
+			}
+		};
+		
+		template <typename Source>
+		class LazyTake {
+			Source source;
+			std::size_t count;
+		public:
+			typedef typename Source::Value Value;
+			
+			LazyTake(const Source& source, const std::size_t count): source(source), count(count) {}
+			
+			template <typename Consumer>
+			bool run(Consumer& consumer) const {
+				
+				if (count == 0) { return true; }
+				
+				std::size_t takenCount = 0;
+				bool isConsumerStopped = false;
+				
+				auto take = [&](Value value) {
+					takenCount += 1;
+					if (!consumer(std::forward<Value>(value))) {
+						isConsumerStopped = true;
+						return false;
+					}
+					return takenCount < count;
+				};
+				source.run(take);
+				
+				return !isConsumerStopped;
+			}
+		};
+		
+		template <typename Source>
+		class LazyDrop {
+			Source source;
+			std::size_t count;
+		public:
+			typedef typename Source::Value Value;
+			
+			LazyDrop(const Source& source, const std::size_t count): source(source), count(count) {}
+			
+			template <typename Consumer>
+			bool run(Consumer& consumer) const {
+				std::size_t droppedCount = 0;
+				auto drop = [&](Value value) {
+					if (droppedCount < count) {
+						droppedCount += 1;
+						return true;
+					}
+					return consumer(std::forward<Value>(value));
+				};
+				return source.run(drop);
+			}
+		};
+		
+		template <typename Source>
+		class LazyEnumerate {
+			Source source;
+		public:
+			typedef std::pair<std::size_t, typename Source::Value> Value;
+			
+			LazyEnumerate(const Source& source): source(source) {}
+			
+			template <typename Consumer>
+			bool run(Consumer& consumer) const {
+				std::size_t index = 0;
+				auto enumerate = [&](typename Source::Value value) {
+					return consumer(Value(index++, std::forward<typename Source::Value>(value)));
+				};
+				return source.run(enumerate);
+			}
+		};
+		
+		/// Stops at the end of the shortest one
+		template <typename Source, typename Container>
+		class LazyZip {
+			Source source;
+			const Container* container;
+		public:
+			typedef decltype(*std::begin(std::declval<const Container&>())) OtherValue;
+			typedef std::pair<typename Source::Value, OtherValue> Value;
+			
+			LazyZip(const Source& source, const Container& container): source(source), container(&container) {}
+			
+			template <typename Consumer>
+			bool run(Consumer& consumer) const {
+				
+				auto otherElement = std::begin(*container);
+				const auto otherEnd = std::end(*container);
+				bool isConsumerStopped = false;
+				
+				auto zip = [&](typename Source::Value value) {
+					if (otherElement == otherEnd) { return false; }
+					if (!consumer(Value(std::forward<typename Source::Value>(value), *otherElement))) {
+						isConsumerStopped = true;
+						return false;
+					}
+					++otherElement;
+					return true;
+				};
+				source.run(zip);
+				
+				return !isConsumerStopped;
+			}
+		};
+		
+		/// Groups the values in arrays of chunkSize values (the last one can be smaller). The same array is reused for every chunk
+		template <typename Source>
+		class LazyChunked {
+			Source source;
+			std::size_t chunkSize;
+		public:
+			typedef Array<typename LazyElement<typename Source::Value>::type, DefaultAllocator, 0, DefaultGrowth> Chunk;
+			typedef const Chunk& Value;
+			
+			LazyChunked(const Source& source, const std::size_t chunkSize): source(source), chunkSize(chunkSize > 0 ? chunkSize : 1) {}
+			
+			template <typename Consumer>
+			bool run(Consumer& consumer) const {
+				
+				Chunk chunk(chunkSize);
+				
+				auto chunked = [&](typename Source::Value value) {
+					chunk.append(std::forward<typename Source::Value>(value));
+					if (chunk.count() < chunkSize) { return true; }
+					
+					const bool shouldContinue = consumer(static_cast<const Chunk&>(chunk));
+					chunk.removeAll(true);
+					return shouldContinue;
+				};
+				
+				if (!source.run(chunked)) { return false; }
+				
+				return chunk.isEmpty() || consumer(static_cast<const Chunk&>(chunk));
+			}
+		};
+	}
+	
+	template <typename Source>
+	class LazyView {
+		
+		Source source;
+	
+	public:
+		
+		typedef typename Source::Value Value;
+		typedef typename internalEVT::LazyElement<Value>::type Element;
+		
+		explicit LazyView(const Source& source): source(source) {}
+		
+		// MARK: Stages
+		
+		template <typename Function>
+		LazyView<internalEVT::LazyFilter<Source, Function>> filter(const Function& filterFunction) const {
+			return LazyView<internalEVT::LazyFilter<Source, Function>>(internalEVT::LazyFilter<Source, Function>(source, filterFunction));
+		}
+		
+		template <typename Function>
+		LazyView<internalEVT::LazyMap<Source, Function>> map(const Function& mapFunctor) const {
+			return LazyView<internalEVT::LazyMap<Source, Function>>(internalEVT::LazyMap<Source, Function>(source, mapFunctor));
+		}
+		
+		/// First count values
+		LazyView<internalEVT::LazyTake<Source>> take(const std::size_t count) const {
+			return LazyView<internalEVT::LazyTake<Source>>(internalEVT::LazyTake<Source>(source, count));
+		}
+		
+		/// Skips the first count values
+		LazyView<internalEVT::LazyDrop<Source>> drop(const std::size_t count) const {
+			return LazyView<internalEVT::LazyDrop<Source>>(internalEVT::LazyDrop<Source>(source, count));
+		}
+		
+		/// Pairs of (index, value)
+		LazyView<internalEVT::LazyEnumerate<Source>> enumerate() const {
+			return LazyView<internalEVT::LazyEnumerate<Source>>(internalEVT::LazyEnumerate<Source>(source));
+		}
+		
+		/// Pairs of (value, element of container)
+		template <typename Container>
+		LazyView<internalEVT::LazyZip<Source, Container>> zip(const Container& container) const {
+			return LazyView<internalEVT::LazyZip<Source, Container>>(internalEVT::LazyZip<Source, Container>(source, container));
+		}
+		
+		/// Arrays of chunkSize values
+		LazyView<internalEVT::LazyChunked<Source>> chunked(const std::size_t chunkSize) const {
+			return LazyView<internalEVT::LazyChunked<Source>>(internalEVT::LazyChunked<Source>(source, chunkSize));
+		}
+		
+		// MARK: Terminal functions
+		
+		template <typename Function>
+		void forEach(const Function& function) const {
+			auto forEach = [&](Value value) {
+				function(std::forward<Value>(value));
+				return true;
+			};
+			source.run(forEach);
+		}
+		
+		template <typename ReduceType, typename Function>
+		ReduceType reduce(const Function& reduceFunctor, ReduceType initialValue = ReduceType()) const {
+			ReduceType reducedValue {initialValue};
+			auto reduce = [&](Value value) {
+				reducedValue = reduceFunctor(reducedValue, std::forward<Value>(value));
+				return true;
+			};
+			source.run(reduce);
+			return reducedValue;
+		}
+		
+		std::size_t count() const {
+			std::size_t count = 0;
+			auto countValues = [&](Value) {
+				count += 1;
+				return true;
+			};
+			source.run(countValues);
+			return count;
+		}
+		
+		Optional<Element> first() const {
+			Optional<Element> firstValue;
+			auto findFirst = [&](Value value) {
+				firstValue = Element(std::forward<Value>(value));
+				return false;
+			};
+			source.run(findFirst);
+			return firstValue;
+		}
+		
+		template <typename Allocator = DefaultAllocator>
+		Array<Element, Allocator, 0, DefaultGrowth> toArray(const Allocator& allocator = Allocator()) const {
+			Array<Element, Allocator, 0, DefaultGrowth> array(allocator);
+			auto append = [&](Value value) {
+				array.append(Element(std::forward<Value>(value)));
+				return true;
+			};
+			source.run(append);
+			return array;
+		}
+	};
+}
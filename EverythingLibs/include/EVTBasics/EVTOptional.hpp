@@ -28,6 +28,9 @@
 #include <cstddef>
 #include <ostream>
 #include <stdexcept>
+#include <new>
+#include <utility>
+#include <type_traits>
 
 #if (__cplusplus > 201103L)
 #define CONSTEXPR constexpr
@@ -43,169 +46,146 @@ namespace evt {
 		};
 	}
 	
+	/// A value or null. The value is stored inside the optional, so it never allocates memory by itself
 	template <typename Type>
 	class Optional {
 		
 	private:
-		Type* value_ { nullptr };
+		// Only constructed while hasValue_ is true
+		alignas(Type) mutable unsigned char storage_[sizeof(Type)];
+		bool hasValue_ {false};
 		
-		void freePointer() {
-			if (this->isNotNull()) {
-				delete value_;
-				value_ = nullptr;
+		Type* valuePointer() const noexcept {
+			return reinterpret_cast<Type*>(storage_);
+		}
+		
+		template <typename Value>
+		void constructValue(Value&& value) {
+			::new (static_cast<void*>(storage_)) Type(std::forward<Value>(value));
+			hasValue_ = true;
+		}
+		
+		/// Assigns to the current value if there is one, so its resources (like a string buffer) are reused
+		template <typename Value>
+		void assignValue(Value&& value) {
+			if (hasValue_) {
+				*valuePointer() = std::forward<Value>(value);
+			} else {
+				constructValue(std::forward<Value>(value));
+			}
+		}
+		
+		void destroyValue() noexcept {
+			if (hasValue_) {
+				valuePointer()->~Type();
+				hasValue_ = false;
 			}
 		}
 		
 	public:
 		
-		CONSTEXPR Optional(const Optional& other) { this->operator=(other); }
-		CONSTEXPR Optional(std::nullptr_t value = nullptr) { this->value_ = value; }
-		CONSTEXPR Optional(const Type& value) { this->value_ = new Type{value}; }
-		CONSTEXPR Optional(Type&& value) { this->value_ = new Type{std::move(value)}; }
+		CONSTEXPR Optional(std::nullptr_t = nullptr) noexcept {}
+		CONSTEXPR Optional(const Type& value) { constructValue(value); }
+		CONSTEXPR Optional(Type&& value) { constructValue(std::move(value)); }
+		
+		CONSTEXPR Optional(const Optional& other) {
+			if (other.hasValue_) { constructValue(*other.valuePointer()); }
+		}
+		
+		CONSTEXPR Optional(Optional&& other) noexcept(std::is_nothrow_move_constructible<Type>::value) {
+			if (other.hasValue_) { constructValue(std::move(*other.valuePointer())); }
+		}
 		
 		CONSTEXPR Type valueOr(const Type& other) const { return (this->isNotNull()) ? this->value() : other; }
 		CONSTEXPR Type orEmpty() const { return (this->isNotNull()) ? this->value() : Type{}; }
-		CONSTEXPR bool isNull() const { return value_ == nullptr; }
-		CONSTEXPR bool isNotNull() const { return value_ != nullptr; }
-		CONSTEXPR bool operator==(const Optional& other) const { return value_ == other.value_; }
-		CONSTEXPR bool operator!=(const Optional& other) const { return value_ != other.value_; }
-		CONSTEXPR bool operator==(const Type& otherValue) const noexcept { return this->isNotNull() ? (*value_ == otherValue) : false; }
-		CONSTEXPR bool operator!=(const Type& otherValue) const noexcept { return this->isNotNull() ? (*value_ != otherValue) : false; }
-		CONSTEXPR bool operator==(std::nullptr_t none) const noexcept { return value_ == none; }
-		CONSTEXPR bool operator!=(std::nullptr_t none) const noexcept { return value_ != none; }
-		CONSTEXPR Type& operator*() const { return *value_; }
+		CONSTEXPR bool isNull() const noexcept { return !hasValue_; }
+		CONSTEXPR bool isNotNull() const noexcept { return hasValue_; }
+		CONSTEXPR bool operator==(const Optional& other) const { return (hasValue_ && other.hasValue_) ? (*valuePointer() == *other.valuePointer()) : (hasValue_ == other.hasValue_); }
+		CONSTEXPR bool operator!=(const Optional& other) const { return !(*this == other); }
+		CONSTEXPR bool operator==(const Type& otherValue) const noexcept { return this->isNotNull() ? (*valuePointer() == otherValue) : false; }
+		CONSTEXPR bool operator!=(const Type& otherValue) const noexcept { return this->isNotNull() ? (*valuePointer() != otherValue) : false; }
+		CONSTEXPR bool operator==(std::nullptr_t) const noexcept { return !hasValue_; }
+		CONSTEXPR bool operator!=(std::nullptr_t) const noexcept { return hasValue_; }
+		CONSTEXPR Type& operator*() const { return *valuePointer(); }
 		CONSTEXPR Type& value() const {
 			if (this->isNull()) { throw internalEVT::badAccess(); }
-			return *value_;
+			return *valuePointer();
 		}
-		CONSTEXPR explicit operator bool() const { return this->isNotNull(); }
+		CONSTEXPR explicit operator bool() const noexcept { return this->isNotNull(); }
 		CONSTEXPR operator Type() const { return this->orEmpty(); }
 		
-		CONSTEXPR friend std::ostream& operator<<(std::ostream& os, const Optional& optionalValue) {
-			return os << optionalValue.orEmpty();
+		/// Optional with function(value), or null
+		template <typename Function>
+		auto map(const Function& function) const -> Optional<typename std::decay<decltype(function(std::declval<const Type&>()))>::type> {
+			if (hasValue_) {
+				return function(*valuePointer());
+			}
+			return nullptr;
 		}
 		
-		CONSTEXPR Optional& operator=(const Optional& other) {
-			freePointer();
-			if (other.isNull()) {
-				this->value_ = nullptr;
-			} else {
-				this->value_ = new Type{other.value()};
+		/// The optional returned by function(value), or null
+		template <typename Function>
+		auto flatMap(const Function& function) const -> typename std::decay<decltype(function(std::declval<const Type&>()))>::type {
+			if (hasValue_) {
+				return function(*valuePointer());
 			}
-			return *this;
+			return nullptr;
 		}
 		
-		CONSTEXPR Optional& operator=(const Type& value) {
-			if (this->isNull()) {
-				this->value_ = new Type{value};
-			} else {
-				*this->value_ = value;
+		/// This optional if it has a value, otherwise the optional returned by function()
+		template <typename Function>
+		Optional orElse(const Function& function) const {
+			if (hasValue_) {
+				return *this;
 			}
-			return *this;
+			return function();
 		}
 		
-		CONSTEXPR Optional& operator=(Type&& value) {
-			if (this->isNull()) {
-				this->value_ = new Type{std::move(value)};
-			} else {
-				*this->value_ = std::move(value);
-			}
-			return *this;
+		CONSTEXPR friend std::ostream& operator<<(std::ostream& os, const Optional& optionalValue) {
+			return os << optionalValue.orEmpty();
 		}
 		
-		CONSTEXPR Optional& operator=(std::nullptr_t none) {
-			if (none == nullptr) {
-				freePointer();
+		CONSTEXPR Optional& operator=(const Optional& other) {
+			if (this != &other) {
+				if (other.hasValue_) {
+					assignValue(*other.valuePointer());
+				} else {
+					destroyValue();
+				}
 			}
 			return *this;
 		}
 		
-		~Optional() {
-			if (this->isNotNull()) {
-				delete value_;
-				value_ = nullptr;
+		CONSTEXPR Optional& operator=(Optional&& other) {
+			if (this != &other) {
+				if (other.hasValue_) {
+					assignValue(std::move(*other.valuePointer()));
+				} else {
+					destroyValue();
+				}
 			}
+			return *this;
 		}
-	};
-}
-
-/*
- // Working fine only on Clang!
- #pragma once
-
-#include <cstddef>
-#include <ostream>
-
-#if (__cplusplus > 201103L)
-	#define CONSTEXPR constexpr
-	#define CONSTEXPRvar constexpr
-#else
-	#define CONSTEXPR inline
-	#define CONSTEXPRvar
-#endif
-
-namespace evt {
-	
-	template <typename Type>
-	union Optional {
 		
-	private:
-		
-		std::nullptr_t none;
-		Type some{};
-		
-	public:
-		
-		Optional(const Optional& otherOptionalType) { this->operator=(otherOptionalType); }
-		Optional(Optional&& otherOptionalType) { this->operator=(std::move(otherOptionalType)); }
-		
-		Optional(std::nullptr_t none = nullptr): none(none) {}
-		Optional(const Type& something): some(something) { }
-		Optional(Type&& something): some(std::move(something)) { }
-		
-		CONSTEXPR Optional& operator=(const Type& something) { this->some = something; return *this; }
-		CONSTEXPR Optional& operator=(Type&& something) { this->some = std::move(something); return *this; }
-		CONSTEXPR Optional& operator=(std::nullptr_t none) { this->none = none; return *this; }
-		
-		CONSTEXPR Optional& operator=(const Optional& otherOptionalType) {
-			this->none = otherOptionalType.none;
-			this->some = otherOptionalType.some;
+		CONSTEXPR Optional& operator=(const Type& value) {
+			assignValue(value);
 			return *this;
 		}
 		
-		CONSTEXPR Optional& operator=(Optional&& otherOptionalType) {
-			this->none = std::move(otherOptionalType.none);
-			this->some = std::move(otherOptionalType.some);
+		CONSTEXPR Optional& operator=(Type&& value) {
+			assignValue(std::move(value));
 			return *this;
 		}
 		
-		~Optional() { some.~Type(); }
-		
-		bool isNotNull() const noexcept { return none != nullptr; }
-		CONSTEXPR bool isNull() const noexcept { return none == nullptr; }
-		CONSTEXPR bool operator==(const Optional& other) const noexcept { return some == other.some && none == other.none; }
-		CONSTEXPR bool operator!=(const Optional& other) const noexcept { return some != other.some && none != other.none; }
-		CONSTEXPR bool operator==(const Type& otherValue) const noexcept { return some == otherValue; }
-		CONSTEXPR bool operator!=(const Type& otherValue) const noexcept { return some != otherValue; }
-		CONSTEXPR bool operator==(const std::nullptr_t& none) const noexcept { return this->none == none; }
-		CONSTEXPR bool operator!=(const std::nullptr_t& none) const noexcept { return this->none != none; }
-		CONSTEXPR Type operator*() const noexcept { return some; }
-		CONSTEXPR Type value() const noexcept { return some; }
-		CONSTEXPR Type& value() noexcept { return some; }
-		CONSTEXPR explicit operator bool() const noexcept { return this->isNotNull(); }
-		CONSTEXPR operator Type() const noexcept { return this->orEmpty(); }
-		CONSTEXPR Type orEmpty() const noexcept { return this->isNotNull() ? some : Type{}; }
-		
-		CONSTEXPR Type valueOr(const Type& other) const noexcept {
-			return this->isNotNull() ? some : other;
+		CONSTEXPR Optional& operator=(std::nullptr_t) noexcept {
+			destroyValue();
+			return *this;
 		}
 		
-		template <typename ValueType>
-		CONSTEXPR friend std::ostream& operator<<(std::ostream& os, const Optional<ValueType>& optionalValue) noexcept {
-			return os << optionalValue.orEmpty();
+		~Optional() {
+			destroyValue();
 		}
 	};
 }
-*/
 
 #undef CONSTEXPR
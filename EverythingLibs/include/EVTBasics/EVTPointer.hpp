@@ -30,6 +30,10 @@
 #include <utility>
 #include <algorithm>
 #include <utility>
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <cstddef>
 
 #if (__cplusplus > 201103L)
 #define CONSTEXPR constexpr
@@ -37,35 +41,58 @@
 #define CONSTEXPR
 #endif
 
+// glibc tells when the program hasn't started any thread, then atomic counts can be updated without atomic instructions
+#if defined(__has_include)
+	#if __has_include(<sys/single_threaded.h>)
+		#include <sys/single_threaded.h>
+		#define EVT_POINTER_SINGLE_THREADED_CHECK
+	#endif
+#endif
+
 namespace evt {
 	
 	template <typename Type>
 	class Pointer {
 		
-		std::unique_ptr<Type> valuePtr {new Type{}};
+		// A null pointer reads as a value-initialized value, and creates it the first time it's modified
+		std::unique_ptr<Type> valuePtr;
+		
+		/// What a null pointer reads as
+		static const Type& emptyValue() {
+			static const Type value{};
+			return value;
+		}
 		
 	public:
 		
-		CONSTEXPR Pointer() noexcept {
-			valuePtr = std::unique_ptr<Type>(new Type{});
-		}
+		CONSTEXPR Pointer() noexcept {}
 		
-		CONSTEXPR Pointer(const Type& value) noexcept {
-			valuePtr = std::unique_ptr<Type>(new Type{value});
-		}
+		CONSTEXPR Pointer(const Type& value): valuePtr(new Type{value}) {}
 		
 		CONSTEXPR Pointer(Pointer& otherPtr) noexcept {
 			this->operator=(otherPtr);
 		}
 		
-		CONSTEXPR Type& operator*() const {
-			if (valuePtr == nullptr) { throw std::bad_alloc(); }
+		CONSTEXPR Pointer(Pointer&& otherPtr) noexcept: valuePtr(std::move(otherPtr.valuePtr)) {}
+		
+		/// A null pointer gets a value-initialized value here
+		CONSTEXPR Type& operator*() {
+			allocateIfNeeded();
 			return *valuePtr;
 		}
 		
+		/// Doesn't allocate, so it's safe to read the same pointer from many threads (a null pointer reads as a value-initialized value)
+		CONSTEXPR const Type& operator*() const {
+			return (valuePtr != nullptr) ? *valuePtr : emptyValue();
+		}
+		
+		/// Creates the value-initialized value of a null pointer
+		CONSTEXPR void allocateIfNeeded() {
+			if (valuePtr == nullptr) { valuePtr.reset(new Type{}); }
+		}
+		
 		CONSTEXPR operator Type() const {
-			if (valuePtr == nullptr) { throw std::bad_alloc(); }
-			return *valuePtr;
+			return this->operator*();
 		}
 		
 		CONSTEXPR bool isNull() const noexcept {
@@ -80,29 +107,27 @@ namespace evt {
 			valuePtr = std::move(otherPtr.valuePtr);
 			return *this;
 		}
+		
+		CONSTEXPR Pointer& operator=(Pointer&& otherPtr) noexcept {
+			valuePtr = std::move(otherPtr.valuePtr);
+			return *this;
+		}
 	};
 	
 	template <typename Type>
 	class Pointer<Type[]> {
 		
-		std::size_t capacity_ {1};
-		std::unique_ptr<Type[]> valuePtr {new Type[capacity_]{}};
+		std::size_t capacity_ {0};
+		std::unique_ptr<Type[]> valuePtr;
 		
 	public:
 		
-		CONSTEXPR Pointer() noexcept {
-			this->valuePtr = std::unique_ptr<Type[]>(new Type[capacity_]{});
-		}
+		/// Empty, without memory
+		CONSTEXPR Pointer() noexcept {}
 		
-		CONSTEXPR Pointer(const std::size_t capacity) noexcept {
-			this->capacity_ = capacity;
-			this->valuePtr = std::unique_ptr<Type[]>(new Type[capacity_]{});
-		}
+		CONSTEXPR Pointer(const std::size_t capacity): capacity_(capacity), valuePtr((capacity > 0) ? new Type[capacity]{} : nullptr) {}
 		
-		CONSTEXPR Pointer(std::initializer_list<Type> values) noexcept {
-			
-			this->capacity_ = values.size();
-			this->valuePtr = std::unique_ptr<Type[]>(new Type[capacity_]{});
+		CONSTEXPR Pointer(std::initializer_list<Type> values): capacity_(values.size()), valuePtr((values.size() > 0) ? new Type[values.size()]{} : nullptr) {
 			
 			size_t index = 0;
 			for (const auto& value: values) {
@@ -115,8 +140,8 @@ namespace evt {
 			this->operator=(otherPtr);
 		}
 		
-		CONSTEXPR Pointer(Pointer<Type[]>&& otherPtr) noexcept {
-			this->operator=(otherPtr);
+		CONSTEXPR Pointer(Pointer<Type[]>&& otherPtr) noexcept: capacity_(otherPtr.capacity_), valuePtr(std::move(otherPtr.valuePtr)) {
+			otherPtr.capacity_ = 0;
 		}
 		
 		CONSTEXPR Type& operator[](const std::size_t index) const {
@@ -137,11 +162,11 @@ namespace evt {
 		}
 		
 		CONSTEXPR Type* begin() const noexcept {
-			return &valuePtr[0];
+			return valuePtr.get();
 		}
 		
 		CONSTEXPR Type* end() const noexcept {
-			return &valuePtr[capacity_];
+			return valuePtr.get() + capacity_;
 		}
 		
 		CONSTEXPR Pointer& operator=(Pointer<Type[]>& otherPtr) noexcept {
@@ -165,7 +190,7 @@ namespace evt {
 		}
 		
 		CONSTEXPR bool operator==(Pointer<Type[]>& otherPtr) {
-			return std::equal(&valuePtr[0], &valuePtr[capacity_], otherPtr.begin());
+			return std::equal(this->begin(), this->end(), otherPtr.begin());
 		}
 		
 		template <typename Container>
@@ -194,6 +219,306 @@ namespace evt {
 			return valuePtr != nullptr;
 		}
 	};
+	
+	/// Reference counts that can be shared between threads (the default for SharedPointer)
+	struct AtomicReferenceCount {
+		
+		typedef std::atomic<std::size_t> Counter;
+		
+		static bool isSingleThreaded() noexcept {
+			#ifdef EVT_POINTER_SINGLE_THREADED_CHECK
+				return __libc_single_threaded;
+			#else
+				return false;
+			#endif
+		}
+		
+		static void increment(Counter& counter) noexcept {
+			if (isSingleThreaded()) {
+				counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+				return;
+			}
+			counter.fetch_add(1, std::memory_order_relaxed);
+		}
+		
+		/// Returns the count after decrementing it
+		static std::size_t decrement(Counter& counter) noexcept {
+			if (isSingleThreaded()) {
+				const std::size_t count = counter.load(std::memory_order_relaxed) - 1;
+				counter.store(count, std::memory_order_relaxed);
+				return count;
+			}
+			return counter.fetch_sub(1, std::memory_order_acq_rel) - 1;
+		}
+		
+		/// Used to lock weak pointers, a count of 0 can't grow again
+		static bool incrementIfNotZero(Counter& counter) noexcept {
+			std::size_t count = counter.load(std::memory_order_relaxed);
+			while (count != 0) {
+				if (counter.compare_exchange_weak(count, count + 1, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+					return true;
+				}
+			}
+			return false;
+		}
+		
+		static std::size_t load(const Counter& counter) noexcept {
+			return counter.load(std::memory_order_acquire);
+		}
+	};
+	
+	/// Plain reference counts, faster but only for pointers whose copies stay in one thread
+	struct NonAtomicReferenceCount {
+		
+		typedef std::size_t Counter;
+		
+		static void increment(Counter& counter) noexcept {
+			counter += 1;
+		}
+		
+		static std::size_t decrement(Counter& counter) noexcept {
+			return --counter;
+		}
+		
+		static bool incrementIfNotZero(Counter& counter) noexcept {
+			if (counter == 0) { return false; }
+			counter += 1;
+			return true;
+		}
+		
+		static std::size_t load(const Counter& counter) noexcept {
+			return counter;
+		}
+	};
+	
+	namespace internalEVT {
+		
+		/// Counts of a shared value. The weak count has one more reference while there are strong ones,
+		/// so the block is freed by whichever pointer (strong or weak) is the last one
+		template <typename ReferenceCount>
+		struct SharedBlock {
+			
+			typename ReferenceCount::Counter strongCount {1};
+			typename ReferenceCount::Counter weakCount {1};
+			void (*destroyValue)(SharedBlock*);
+			void (*deallocate)(SharedBlock*);
+			
+			void retain() noexcept {
+				ReferenceCount::increment(strongCount);
+			}
+			
+			void retainWeak() noexcept {
+				ReferenceCount::increment(weakCount);
+			}
+			
+			void release() noexcept {
+				if (ReferenceCount::decrement(strongCount) == 0) {
+					destroyValue(this);
+					// Without weak pointers nobody else can reach the block
+					if (ReferenceCount::load(weakCount) == 1) {
+						deallocate(this);
+					} else {
+						releaseWeak();
+					}
+				}
+			}
+			
+			void releaseWeak() noexcept {
+				if (ReferenceCount::decrement(weakCount) == 0) {
+					deallocate(this);
+				}
+			}
+		};
+		
+		/// The counts and the value in a single allocation
+		template <typename Type, typename ReferenceCount>
+		struct SharedBlockWithValue: SharedBlock<ReferenceCount> {
+			
+			alignas(Type) unsigned char storage[sizeof(Type)];
+			
+			Type* value() noexcept {
+				return reinterpret_cast<Type*>(storage);
+			}
+			
+			static void destroy(SharedBlock<ReferenceCount>* block) {
+				static_cast<SharedBlockWithValue*>(block)->value()->~Type();
+			}
+			
+			static void free(SharedBlock<ReferenceCount>* block) {
+				delete static_cast<SharedBlockWithValue*>(block);
+			}
+		};
+	}
+	
+	template <typename Type, typename ReferenceCount>
+	class WeakPointer;
+	
+	/// Reference counted pointer whose counts live in the same allocation as the value (see SharedPointer::make).
+	/// ReferenceCount is AtomicReferenceCount, or NonAtomicReferenceCount for values that are only used by one thread.
+	///
+	/// Example:
+	///
+	///	auto settings = evt::SharedPointer<Settings>::make("settings.json");
+	///	evt::WeakPointer<Settings> observer = settings;
+	///	if (auto lockedSettings = observer.lock()) { ... }
+	template <typename Type, typename ReferenceCount = AtomicReferenceCount>
+	class SharedPointer {
+		
+		typedef internalEVT::SharedBlock<ReferenceCount> Block;
+		
+		Type* valuePtr {nullptr};
+		Block* block {nullptr};
+		
+		template <typename, typename> friend class SharedPointer;
+		template <typename, typename> friend class WeakPointer;
+		
+		SharedPointer(Type* value, Block* valueBlock) noexcept: valuePtr(value), block(valueBlock) {}
+	
+	public:
+		
+		CONSTEXPR SharedPointer() noexcept {}
+		
+		/// Creates the value with the given arguments, with one allocation for the value and its counts
+		template <typename... Arguments>
+		static SharedPointer make(Arguments&&... arguments) {
+			
+			typedef internalEVT::SharedBlockWithValue<Type, ReferenceCount> BlockWithValue;
+			
+			BlockWithValue* newBlock = new BlockWithValue;
+			
+			try {
+				::new (static_cast<void*>(newBlock->storage)) Type{std::forward<Arguments>(arguments)...};
+			} catch (...) {
+				delete newBlock;
+				throw;
+			}
+			
+			newBlock->destroyValue = &BlockWithValue::destroy;
+			newBlock->deallocate = &BlockWithValue::free;
+			
+			return SharedPointer(newBlock->value(), newBlock);
+		}
+		
+		SharedPointer(const SharedPointer& otherPtr) noexcept: valuePtr(otherPtr.valuePtr), block(otherPtr.block) {
+			if (block != nullptr) { block->retain(); }
+		}
+		
+		SharedPointer(SharedPointer&& otherPtr) noexcept: valuePtr(otherPtr.valuePtr), block(otherPtr.block) {
+			otherPtr.valuePtr = nullptr;
+			otherPtr.block = nullptr;
+		}
+		
+		/// From pointers to derived types (or to any type, for SharedPointer<void>)
+		template <typename OtherType, typename = typename std::enable_if<std::is_convertible<OtherType*, Type*>::value>::type>
+		SharedPointer(const SharedPointer<OtherType, ReferenceCount>& otherPtr) noexcept: valuePtr(otherPtr.valuePtr), block(otherPtr.block) {
+			if (block != nullptr) { block->retain(); }
+		}
+		
+		template <typename OtherType, typename = typename std::enable_if<std::is_convertible<OtherType*, Type*>::value>::type>
+		SharedPointer(SharedPointer<OtherType, ReferenceCount>&& otherPtr) noexcept: valuePtr(otherPtr.valuePtr), block(otherPtr.block) {
+			otherPtr.valuePtr = nullptr;
+			otherPtr.block = nullptr;
+		}
+		
+		SharedPointer& operator=(SharedPointer otherPtr) noexcept {
+			this->swap(otherPtr);
+			return *this;
+		}
+		
+		~SharedPointer() {
+			if (block != nullptr) { block->release(); }
+		}
+		
+		CONSTEXPR typename std::add_lvalue_reference<Type>::type operator*() const {
+			if (valuePtr == nullptr) { throw std::bad_alloc(); }
+			return *valuePtr;
+		}
+		
+		CONSTEXPR Type* operator->() const {
+			if (valuePtr == nullptr) { throw std::bad_alloc(); }
+			return valuePtr;
+		}
+		
+		CONSTEXPR Type* get() const noexcept {
+			return valuePtr;
+		}
+		
+		CONSTEXPR explicit operator bool() const noexcept {
+			return valuePtr != nullptr;
+		}
+		
+		CONSTEXPR bool isNull() const noexcept {
+			return valuePtr == nullptr;
+		}
+		
+		CONSTEXPR bool isNotNull() const noexcept {
+			return valuePtr != nullptr;
+		}
+		
+		/// Number of SharedPointers to the value (weak ones aren't counted)
+		std::size_t referenceCount() const noexcept {
+			return (block != nullptr) ? ReferenceCount::load(block->strongCount) : 0;
+		}
+		
+		void reset() noexcept {
+			SharedPointer().swap(*this);
+		}
+		
+		void swap(SharedPointer& otherPtr) noexcept {
+			std::swap(valuePtr, otherPtr.valuePtr);
+			std::swap(block, otherPtr.block);
+		}
+	};
+	
+	/// Reference to the value of SharedPointers that doesn't keep it alive, use lock() to access it
+	template <typename Type, typename ReferenceCount = AtomicReferenceCount>
+	class WeakPointer {
+		
+		typedef internalEVT::SharedBlock<ReferenceCount> Block;
+		
+		Type* valuePtr {nullptr};
+		Block* block {nullptr};
+	
+	public:
+		
+		CONSTEXPR WeakPointer() noexcept {}
+		
+		WeakPointer(const SharedPointer<Type, ReferenceCount>& sharedPtr) noexcept: valuePtr(sharedPtr.valuePtr), block(sharedPtr.block) {
+			if (block != nullptr) { block->retainWeak(); }
+		}
+		
+		WeakPointer(const WeakPointer& otherPtr) noexcept: valuePtr(otherPtr.valuePtr), block(otherPtr.block) {
+			if (block != nullptr) { block->retainWeak(); }
+		}
+		
+		WeakPointer(WeakPointer&& otherPtr) noexcept: valuePtr(otherPtr.valuePtr), block(otherPtr.block) {
+			otherPtr.valuePtr = nullptr;
+			otherPtr.block = nullptr;
+		}
+		
+		WeakPointer& operator=(WeakPointer otherPtr) noexcept {
+			std::swap(valuePtr, otherPtr.valuePtr);
+			std::swap(block, otherPtr.block);
+			return *this;
+		}
+		
+		~WeakPointer() {
+			if (block != nullptr) { block->releaseWeak(); }
+		}
+		
+		/// A SharedPointer to the value, null if the value doesn't exist anymore
+		SharedPointer<Type, ReferenceCount> lock() const noexcept {
+			if (block != nullptr && ReferenceCount::incrementIfNotZero(block->strongCount)) {
+				return SharedPointer<Type, ReferenceCount>(valuePtr, block);
+			}
+			return SharedPointer<Type, ReferenceCount>();
+		}
+		
+		bool isExpired() const noexcept {
+			return block == nullptr || ReferenceCount::load(block->strongCount) == 0;
+		}
+	};
 }
 
 #undef CONSTEXPR
+#undef EVT_POINTER_SINGLE_THREADED_CHECK
@@ -30,6 +30,11 @@
 #include <utility>
 #include <algorithm>
 #include <utility>
+#include <new>
+#include <type_traits>
+#include <cstdlib>
+#include <cstddef>
+#include "EVTAllocator.hpp"
 
 #if (__cplusplus > 201103L)
 #define CONSTEXPR constexpr
@@ -39,22 +44,57 @@
 
 namespace evt {
 	
+	/// Tag to request raw (uninitialized) storage, the owner of the memory constructs and destroys the elements
+	struct UninitializedTag { explicit UninitializedTag() = default; };
+	constexpr UninitializedTag uninitialized {};
+	
+	/// Types that can be moved to other memory with a plain memcpy (and not destroyed afterwards).
+	/// Specialize it for your own types, e.g: template <> struct evt::isTriviallyRelocatable<MyType> { static constexpr bool value = true; };
 	template <typename Type>
+	struct isTriviallyRelocatable {
+		static constexpr bool value = std::is_trivially_copyable<Type>::value;
+	};
+	
+	template <typename Type, typename Allocator = DefaultAllocator>
 	class RawPointer {
 		
-		Type* valuePtr {new Type{}};
+		// A null pointer reads as a value-initialized value, and creates it the first time it's modified
+		Allocator allocator_;
+		Type* valuePtr {nullptr};
+		
+		/// What a null pointer reads as
+		static const Type& emptyValue() {
+			static const Type value{};
+			return value;
+		}
+		
+		template <typename... Arguments>
+		Type* newValue(Arguments&&... arguments) {
+			
+			void* memory = allocator_.allocate(sizeof(Type), alignof(Type));
+			
+			try {
+				return ::new (memory) Type{std::forward<Arguments>(arguments)...};
+			} catch (...) {
+				allocator_.deallocate(memory, sizeof(Type), alignof(Type));
+				throw;
+			}
+		}
 		
 		CONSTEXPR void freePointer() {
 			if (valuePtr != nullptr) {
-				delete valuePtr;
+				valuePtr->~Type();
+				allocator_.deallocate(valuePtr, sizeof(Type), alignof(Type));
 				valuePtr = nullptr;
 			}
 		}
 		
 		CONSTEXPR void copyAssignFrom(const RawPointer& otherPtr) {
-			if (this != &otherPtr && otherPtr.isNotNull()) {
+			if (this != &otherPtr) {
 				this->freePointer();
-				valuePtr = new Type{*otherPtr.valuePtr};
+				if (otherPtr.isNotNull()) {
+					valuePtr = newValue(*otherPtr.valuePtr);
+				}
 			}
 		}
 		
@@ -62,42 +102,52 @@ namespace evt {
 		
 		CONSTEXPR RawPointer(){ }
 		
-		CONSTEXPR RawPointer(const Type& value) {
-			valuePtr = new Type{value};
-		}
+		CONSTEXPR RawPointer(const Type& value, const Allocator& allocator = Allocator()): allocator_(allocator), valuePtr(newValue(value)) {}
 		
 		CONSTEXPR RawPointer(RawPointer& otherPtr) {
 			copyAssignFrom(otherPtr);
 		}
 		
-		CONSTEXPR RawPointer(RawPointer&& otherPtr) {
-			this->operator=(std::move(otherPtr));
+		/// Takes the value of the other pointer, which becomes null
+		CONSTEXPR RawPointer(RawPointer&& otherPtr) noexcept: allocator_(otherPtr.allocator_), valuePtr(otherPtr.valuePtr) {
+			otherPtr.valuePtr = nullptr;
 		}
 		
-		CONSTEXPR RawPointer operator=(const RawPointer& otherPtr) {
+		CONSTEXPR RawPointer& operator=(const RawPointer& otherPtr) {
 			copyAssignFrom(otherPtr);
 			return *this;
 		}
 		
-		CONSTEXPR RawPointer operator=(RawPointer&& otherPtr) {
+		CONSTEXPR RawPointer& operator=(RawPointer&& otherPtr) noexcept {
 			
-			if (this != &otherPtr && otherPtr.isNotNull()) {
+			if (this != &otherPtr) {
 				this->freePointer();
-				valuePtr = new Type{*otherPtr.valuePtr};
-				otherPtr.freePointer();
+				this->allocator_ = otherPtr.allocator_;
+				this->valuePtr = otherPtr.valuePtr;
+				otherPtr.valuePtr = nullptr;
 			}
 			
 			return *this;
 		}
 		
-		CONSTEXPR Type& operator*() const {
-			if (valuePtr == nullptr) { throw std::bad_alloc(); }
+		/// A null pointer gets a value-initialized value here
+		CONSTEXPR Type& operator*() {
+			allocateIfNeeded();
 			return *valuePtr;
 		}
 		
+		/// Doesn't allocate, so it's safe to read the same pointer from many threads (a null pointer reads as a value-initialized value)
+		CONSTEXPR const Type& operator*() const {
+			return (valuePtr != nullptr) ? *valuePtr : emptyValue();
+		}
+		
+		/// Creates the value-initialized value of a null pointer
+		CONSTEXPR void allocateIfNeeded() {
+			if (valuePtr == nullptr) { valuePtr = newValue(); }
+		}
+		
 		CONSTEXPR operator Type() const {
-			if (valuePtr == nullptr) { throw std::bad_alloc(); }
-			return *valuePtr;
+			return this->operator*();
 		}
 		
 		CONSTEXPR bool isNull() const {
@@ -114,15 +164,55 @@ namespace evt {
 	};
 	
 	
-	template <typename Type>
-	class RawPointer<Type[]> {
+	template <typename Type, typename Allocator>
+	class RawPointer<Type[], Allocator> {
+		
+		Allocator allocator_;
+		std::size_t capacity_ {0};
+		Type* valuePtr {nullptr};
+		bool isUninitialized_ {false};
+		bool ownsMemory_ {true};
+		
+		// Trivially relocatable elements can be moved with realloc, if the allocator supports it
+		static constexpr bool isReallocatable = isTriviallyRelocatable<Type>::value;
+		
+		Type* allocateStorage(const std::size_t capacity) {
+			return static_cast<Type*>(allocator_.allocate(capacity * sizeof(Type), alignof(Type)));
+		}
+		
+		void deallocateStorage(Type* storage, const std::size_t capacity) noexcept {
+			allocator_.deallocate(storage, capacity * sizeof(Type), alignof(Type));
+		}
 		
-		std::size_t capacity_ {1};
-		Type* valuePtr {new Type[capacity_]{}};
+		/// Memory with every element value-initialized (like new Type[capacity]{})
+		Type* allocateInitializedStorage(const std::size_t capacity) {
+			
+			Type* storage = allocateStorage(capacity);
+			std::size_t index = 0;
+			
+			try {
+				for (; index < capacity; ++index) {
+					::new (static_cast<void*>(storage + index)) Type();
+				}
+			} catch (...) {
+				for (std::size_t constructed = 0; constructed < index; ++constructed) {
+					storage[constructed].~Type();
+				}
+				deallocateStorage(storage, capacity);
+				throw;
+			}
+			
+			return storage;
+		}
 		
 		void freePointer() {
 			if (valuePtr != nullptr) {
-				delete[] valuePtr;
+				if (!isUninitialized_) {
+					destroyRange(0, capacity_);
+				}
+				if (ownsMemory_) {
+					deallocateStorage(valuePtr, capacity_);
+				}
 				valuePtr = nullptr;
 			}
 		}
@@ -132,11 +222,24 @@ namespace evt {
 			if (capacity > 0) {
 				this->freePointer();
 				this->capacity_ = capacity;
-				this->valuePtr = new Type[capacity_]{};
+				this->isUninitialized_ = false;
+				this->ownsMemory_ = true;
+				this->valuePtr = allocateInitializedStorage(capacity_);
 			}
 		}
 		
-		CONSTEXPR void copyPointerValuesFrom(const RawPointer<Type[]>& otherPtr) {
+		void assignUninitializedMemoryForCapacity(std::size_t capacity) {
+			this->freePointer();
+			this->capacity_ = capacity;
+			this->isUninitialized_ = true;
+			this->ownsMemory_ = true;
+			this->valuePtr = (capacity > 0) ? allocateStorage(capacity) : nullptr;
+		}
+		
+		CONSTEXPR void copyPointerValuesFrom(const RawPointer& otherPtr) {
+			if (otherPtr.isUninitialized_) {
+				throw std::logic_error("Uninitialized pointers can't be copied, their owner must copy the elements");
+			}
 			if (otherPtr.capacity() != 0 && this != &otherPtr) {
 				assignMemoryForCapacity(otherPtr.capacity_);
 				std::copy(std::begin(otherPtr), std::end(otherPtr), &valuePtr[0]);
@@ -147,10 +250,19 @@ namespace evt {
 		
 		CONSTEXPR RawPointer() {}
 		
-		CONSTEXPR RawPointer(const std::size_t capacity) {
+		CONSTEXPR RawPointer(const std::size_t capacity, const Allocator& allocator = Allocator()): allocator_(allocator) {
 			assignMemoryForCapacity(capacity);
 		}
 		
+		/// Reserves raw memory without constructing any element, use constructAt/destroyRange to manage their lifetime
+		RawPointer(const std::size_t capacity, UninitializedTag, const Allocator& allocator = Allocator()): allocator_(allocator), capacity_(0), valuePtr(nullptr) {
+			assignUninitializedMemoryForCapacity(capacity);
+		}
+		
+		/// Uses raw memory owned by someone else (e.g. an inline buffer), it won't be freed or reallocated
+		RawPointer(Type* memory, const std::size_t capacity, UninitializedTag, const Allocator& allocator = Allocator())
+		: allocator_(allocator), capacity_(capacity), valuePtr(memory), isUninitialized_(true), ownsMemory_(false) {}
+		
 		CONSTEXPR RawPointer(std::initializer_list<Type> values) {
 			
 			assignMemoryForCapacity(values.size());
@@ -162,26 +274,38 @@ namespace evt {
 			}
 		}
 		
-		CONSTEXPR RawPointer(RawPointer<Type[]>&& otherPtr) {
-			this->operator=(std::move(otherPtr));
+		/// Takes the memory of the other pointer, which becomes null (memory it doesn't own stays owned by someone else)
+		CONSTEXPR RawPointer(RawPointer&& otherPtr) noexcept
+		: allocator_(otherPtr.allocator_), capacity_(otherPtr.capacity_), valuePtr(otherPtr.valuePtr),
+		  isUninitialized_(otherPtr.isUninitialized_), ownsMemory_(otherPtr.ownsMemory_) {
+			otherPtr.valuePtr = nullptr;
+			otherPtr.capacity_ = 0;
 		}
 		
-		CONSTEXPR RawPointer(const RawPointer<Type[]>& otherPtr) {
+		CONSTEXPR RawPointer(const RawPointer& otherPtr): allocator_(otherPtr.allocator_) {
 			copyPointerValuesFrom(otherPtr);
 		}
 		
-		CONSTEXPR RawPointer<Type[]>& operator=(const RawPointer<Type[]>& otherPtr) {
+		CONSTEXPR RawPointer& operator=(const RawPointer& otherPtr) {
 			copyPointerValuesFrom(otherPtr);
 			return *this;
 		}
 		
-		CONSTEXPR RawPointer<Type[]>& operator=(RawPointer<Type[]>&& otherPtr)  {
+		CONSTEXPR RawPointer& operator=(RawPointer&& otherPtr) noexcept {
 			
-			if (otherPtr.capacity() != 0 && this != &otherPtr) {
-				assignMemoryForCapacity(otherPtr.capacity_);
-				std::move(std::begin(otherPtr), std::end(otherPtr), &valuePtr[0]);
-				otherPtr.freePointer();
+			if (this == &otherPtr) {
+				return *this;
 			}
+			
+			this->freePointer();
+			this->allocator_ = otherPtr.allocator_;
+			this->capacity_ = otherPtr.capacity_;
+			this->valuePtr = otherPtr.valuePtr;
+			this->isUninitialized_ = otherPtr.isUninitialized_;
+			this->ownsMemory_ = otherPtr.ownsMemory_;
+			otherPtr.valuePtr = nullptr;
+			otherPtr.capacity_ = 0;
+			
 			return *this;
 		}
 
@@ -206,17 +330,16 @@ namespace evt {
 			return capacity_;
 		}
 		
-		CONSTEXPR Type* begin() const {
-			if (valuePtr == nullptr) { throw std::bad_alloc(); }
-			return &valuePtr[0];
+		/// An empty range for a null pointer
+		CONSTEXPR Type* begin() const noexcept {
+			return valuePtr;
 		}
 		
-		CONSTEXPR Type* end() const {
-			if (valuePtr == nullptr) { throw std::bad_alloc(); }
-			return &valuePtr[capacity_];
+		CONSTEXPR Type* end() const noexcept {
+			return valuePtr + capacity_;
 		}
 		
-		CONSTEXPR bool operator==(RawPointer<Type[]>& otherPtr) {
+		CONSTEXPR bool operator==(RawPointer& otherPtr) {
 			return std::equal(&valuePtr[0], &valuePtr[capacity_], otherPtr.begin());
 		}
 		
@@ -229,7 +352,7 @@ namespace evt {
 			std::move(std::begin(container), std::end(container), &(this->at(position)));
 		}
 		
-		CONSTEXPR void moveValuesFrom(RawPointer<Type[]>&& container, std::size_t position = 0) {
+		CONSTEXPR void moveValuesFrom(RawPointer&& container, std::size_t position = 0) {
 			std::move(container.begin(), container.end(), &(this->at(position)));
 		}
 		
@@ -242,10 +365,59 @@ namespace evt {
 			std::copy(std::begin(container), std::end(container), &(this->at(position)));
 		}
 		
-		CONSTEXPR void copyValuesFrom(const RawPointer<Type[]>& container, std::size_t position = 0) {
+		CONSTEXPR void copyValuesFrom(const RawPointer& container, std::size_t position = 0) {
 			std::copy(container.begin(), container.end(), &(this->at(position)));
 		}
 		
+		CONSTEXPR Type* data() const noexcept {
+			return valuePtr;
+		}
+		
+		/// Constructs an element in place, only for uninitialized memory (or already destroyed elements)
+		template <typename... Arguments>
+		void constructAt(const std::size_t index, Arguments&&... arguments) {
+			::new (static_cast<void*>(valuePtr + index)) Type(std::forward<Arguments>(arguments)...);
+		}
+		
+		/// Changes the capacity of uninitialized memory keeping its bytes, in place when possible.
+		/// Returns false if the memory can't be reallocated (then nothing changes)
+		bool reallocate(const std::size_t newCapacity) {
+			
+			if (!isReallocatable || !isUninitialized_ || !ownsMemory_) {
+				return false;
+			}
+			if (newCapacity == 0 || valuePtr == nullptr) {
+				this->assignUninitializedMemoryForCapacity(newCapacity);
+				return true;
+			}
+			
+			void* storage = allocator_.reallocate(static_cast<void*>(valuePtr), capacity_ * sizeof(Type), newCapacity * sizeof(Type), alignof(Type));
+			if (storage == nullptr) {
+				return false;
+			}
+			
+			this->valuePtr = static_cast<Type*>(storage);
+			this->capacity_ = newCapacity;
+			return true;
+		}
+		
+		/// Destroys the elements in [first, last), the memory is kept
+		void destroyRange(const std::size_t first, const std::size_t last) noexcept {
+			if (!std::is_trivially_destructible<Type>::value) {
+				for (std::size_t index = first; index < last; ++index) {
+					valuePtr[index].~Type();
+				}
+			}
+		}
+		
+		CONSTEXPR const Allocator& allocator() const noexcept {
+			return allocator_;
+		}
+		
+		CONSTEXPR bool isUninitialized() const noexcept {
+			return isUninitialized_;
+		}
+		
 		CONSTEXPR bool isNull() const noexcept {
 			return valuePtr == nullptr;
 		}
@@ -0,0 +1,526 @@
+/*
+ The MIT License (MIT)
+ 
+ Copyright (c) 2017 Daniel Illescas Romero <https://github.com/illescasDaniel>
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+/*
+ Vectorized kernels for contiguous arithmetic values (used by Array::sum, min, max, find, countOf...).
+ The kernels are written with GCC/Clang vector extensions and compiled twice on x86: for the baseline
+ instruction set (SSE2 on x86-64) and for AVX2, which is chosen at runtime if the CPU supports it.
+ Other compilers, bool and long double use scalar loops.
+
+ With NaNs, min/max/argmin/argmax still give one of the elements, but which one is unspecified.
+ */
+
+#if defined(__GNUC__) || defined(__clang__)
+	#define EVT_SIMD_VECTORS 1
+	#define EVT_SIMD_INLINE inline __attribute__((always_inline))
+#else
+	#define EVT_SIMD_INLINE inline
+#endif
+
+#if defined(EVT_SIMD_VECTORS) && (defined(__x86_64__) || defined(__i386__))
+	#define EVT_SIMD_X86 1
+#endif
+
+namespace evt {
+	namespace simd {
+		
+		enum class InstructionSet {
+			scalar,
+			vector, // SIMD of the compilation target (SSE2 on x86-64, NEON on ARM64...)
+			avx2
+		};
+		
+		enum class SummationMethod {
+			simple,   // One accumulator per SIMD lane
+			pairwise, // Sums of blocks added in pairs, error grows with log(count)
+			kahan     // Compensated sums, slowest and most precise
+		};
+		
+		/// Accumulator of sum(): 64 bit integers for integers, double for float
+		template <typename Type, typename = void>
+		struct SumType { typedef Type type; };
+		
+		template <typename Type>
+		struct SumType<Type, typename std::enable_if<std::is_integral<Type>::value && std::is_signed<Type>::value>::type> { typedef long long type; };
+		
+		template <typename Type>
+		struct SumType<Type, typename std::enable_if<std::is_integral<Type>::value && std::is_unsigned<Type>::value>::type> { typedef unsigned long long type; };
+		
+		template <>
+		struct SumType<float> { typedef double type; };
+		
+		template <>
+		struct SumType<bool> { typedef std::size_t type; };
+		
+		template <typename Type>
+		struct isVectorizable {
+			static constexpr bool value =
+				#if defined(EVT_SIMD_VECTORS)
+					std::is_arithmetic<Type>::value && !std::is_same<Type, bool>::value && !std::is_same<Type, long double>::value;
+				#else
+					false;
+				#endif
+		};
+		
+		namespace internalSimd {
+			
+			inline InstructionSet detectedInstructionSet() noexcept {
+				#if defined(EVT_SIMD_X86)
+					return __builtin_cpu_supports("avx2") ? InstructionSet::avx2 : InstructionSet::vector;
+				#elif defined(EVT_SIMD_VECTORS)
+					return InstructionSet::vector;
+				#else
+					return InstructionSet::scalar;
+				#endif
+			}
+			
+			inline InstructionSet& selectedInstructionSet() noexcept {
+				static InstructionSet instructionSet = detectedInstructionSet();
+				return instructionSet;
+			}
+		}
+		
+		/// Instruction set used by the kernels, the best one supported by the CPU unless useInstructionSet was called
+		inline InstructionSet instructionSet() noexcept {
+			return internalSimd::selectedInstructionSet();
+		}
+		
+		/// Forces an instruction set (to compare them), the best supported one is used if it's not available
+		inline void useInstructionSet(const InstructionSet instructionSet) noexcept {
+			const InstructionSet best = internalSimd::detectedInstructionSet();
+			internalSimd::selectedInstructionSet() = (int(instructionSet) > int(best)) ? best : instructionSet;
+		}
+		
+		namespace internalSimd {
+			
+			#if defined(EVT_SIMD_VECTORS)
+			
+			// The kernels are always inlined in the dispatch functions, so the vector ABI doesn't matter
+			#pragma GCC diagnostic push
+			#pragma GCC diagnostic ignored "-Wpsabi"
+			
+			// Bytes of the vectors: 16 for the baseline instruction set, 32 for AVX2
+			template <typename Type, std::size_t Lanes>
+			struct VectorOf { typedef Type type __attribute__((vector_size(sizeof(Type) * Lanes))); };
+			
+			template <typename Type, std::size_t Bytes>
+			using Vector = typename VectorOf<Type, Bytes / sizeof(Type)>::type;
+			
+			/// Integer type of the lanes of a comparison result
+			template <typename Type>
+			using MaskLane = typename std::conditional<sizeof(Type) == 1, signed char,
+							 typename std::conditional<sizeof(Type) == 2, short,
+							 typename std::conditional<sizeof(Type) == 4, int, long long>::type>::type>::type;
+			
+			template <typename Type, std::size_t Bytes>
+			using Mask = Vector<MaskLane<Type>, Bytes>;
+			
+			template <typename Vector, typename Type>
+			EVT_SIMD_INLINE Vector load(const Type* values) noexcept {
+				Vector vector;
+				std::memcpy(&vector, values, sizeof(vector));
+				return vector;
+			}
+			
+			template <typename Vector, typename Type>
+			EVT_SIMD_INLINE Vector splat(const Type value) noexcept {
+				Vector vector;
+				for (std::size_t lane = 0; lane < sizeof(Vector) / sizeof(Type); ++lane) {
+					vector[lane] = value;
+				}
+				return vector;
+			}
+			
+			template <typename Type, std::size_t Bytes>
+			EVT_SIMD_INLINE bool isAnyLaneSet(const Mask<Type, Bytes>& mask) noexcept {
+				const Vector<unsigned long long, Bytes> words = (Vector<unsigned long long, Bytes>) mask;
+				unsigned long long anyWord = 0;
+				for (std::size_t word = 0; word < Bytes / sizeof(unsigned long long); ++word) {
+					anyWord |= words[word];
+				}
+				return anyWord != 0;
+			}
+			
+			// Kernels: run() has the vectorized loop, the dispatch functions below compile it for each instruction set
+			
+			template <typename Type, std::size_t Bytes>
+			struct SumKernel {
+				
+				typedef typename SumType<Type>::type Result;
+				
+				EVT_SIMD_INLINE static Result run(const Type* values, const std::size_t count) noexcept {
+					
+					constexpr std::size_t lanes = Bytes / sizeof(Result);
+					typedef Vector<Result, Bytes> Accumulator;
+					typedef typename VectorOf<Type, lanes>::type Source;
+					
+					Accumulator sum0 {}, sum1 {}, sum2 {}, sum3 {};
+					std::size_t index = 0;
+					
+					for (; index + 4 * lanes <= count; index += 4 * lanes) {
+						sum0 += __builtin_convertvector(load<Source>(values + index), Accumulator);
+						sum1 += __builtin_convertvector(load<Source>(values + index + lanes), Accumulator);
+						sum2 += __builtin_convertvector(load<Source>(values + index + 2 * lanes), Accumulator);
+						sum3 += __builtin_convertvector(load<Source>(values + index + 3 * lanes), Accumulator);
+					}
+					for (; index + lanes <= count; index += lanes) {
+						sum0 += __builtin_convertvector(load<Source>(values + index), Accumulator);
+					}
+					
+					const Accumulator sums = (sum0 + sum1) + (sum2 + sum3);
+					Result sum {};
+					for (std::size_t lane = 0; lane < lanes; ++lane) {
+						sum += sums[lane];
+					}
+					for (; index < count; ++index) {
+						sum += Result(values[index]);
+					}
+					return sum;
+				}
+			};
+			
+			template <typename Type, std::size_t Bytes>
+			struct KahanSumKernel {
+				
+				typedef typename SumType<Type>::type Result;
+				
+				EVT_SIMD_INLINE static Result run(const Type* values, const std::size_t count) noexcept {
+					
+					constexpr std::size_t lanes = Bytes / sizeof(Result);
+					typedef Vector<Result, Bytes> Accumulator;
+					typedef typename VectorOf<Type, lanes>::type Source;
+					
+					Accumulator sums {}, compensations {};
+					std::size_t index = 0;
+					
+					for (; index + lanes <= count; index += lanes) {
+						const Accumulator value = __builtin_convertvector(load<Source>(values + index), Accumulator) - compensations;
+						const Accumulator newSums = sums + value;
+						compensations = (newSums - sums) - value;
+						sums = newSums;
+					}
+					
+					Result sum {}, compensation {};
+					auto add = [&](const Result value) {
+						const Result compensatedValue = value - compensation;
+						const Result newSum = sum + compensatedValue;
+						compensation = (newSum - sum) - compensatedValue;
+						sum = newSum;
+					};
+					
+					for (std::size_t lane = 0; lane < lanes; ++lane) {
+						add(sums[lane]);
+						add(-compensations[lane]);
+					}
+					for (; index < count; ++index) {
+						add(Result(values[index]));
+					}
+					return sum;
+				}
+			};
+			
+			/// Smallest (or biggest) value, count must be greater than 0
+			template <typename Type, bool isMaximum, std::size_t Bytes>
+			struct ExtremeKernel {
+				
+				EVT_SIMD_INLINE static Type run(const Type* values, const std::size_t count) noexcept {
+					
+					constexpr std::size_t lanes = Bytes / sizeof(Type);
+					
+					Type extreme = values[0];
+					std::size_t index = 0;
+					
+					if (count >= lanes) {
+						
+						Vector<Type, Bytes> extremes = load<Vector<Type, Bytes>>(values);
+						for (index = lanes; index + lanes <= count; index += lanes) {
+							const Vector<Type, Bytes> vector = load<Vector<Type, Bytes>>(values + index);
+							extremes = (isMaximum ? (vector > extremes) : (vector < extremes)) ? vector : extremes;
+						}
+						for (std::size_t lane = 0; lane < lanes; ++lane) {
+							if (isMaximum ? (extremes[lane] > extreme) : (extremes[lane] < extreme)) { extreme = extremes[lane]; }
+						}
+					}
+					for (; index < count; ++index) {
+						if (isMaximum ? (values[index] > extreme) : (values[index] < extreme)) { extreme = values[index]; }
+					}
+					return extreme;
+				}
+			};
+			
+			/// Index of the first value equal to value, count if there isn't any
+			template <typename Type, std::size_t Bytes>
+			struct FindKernel {
+				
+				EVT_SIMD_INLINE static std::size_t run(const Type* values, const std::size_t count, const Type value) noexcept {
+					
+					constexpr std::size_t lanes = Bytes / sizeof(Type);
+					const Vector<Type, Bytes> wanted = splat<Vector<Type, Bytes>>(value);
+					
+					std::size_t index = 0;
+					for (; index + lanes <= count; index += lanes) {
+						if (isAnyLaneSet<Type, Bytes>(load<Vector<Type, Bytes>>(values + index) == wanted)) { break; }
+					}
+					for (; index < count; ++index) {
+						if (values[index] == value) { return index; }
+					}
+					return count;
+				}
+			};
+			
+			template <typename Type, std::size_t Bytes>
+			struct CountKernel {
+				
+				EVT_SIMD_INLINE static std::size_t run(const Type* values, const std::size_t count, const Type value) noexcept {
+					
+					constexpr std::size_t lanes = Bytes / sizeof(Type);
+					constexpr std::size_t blocksPerFlush = 127; // Lane counters of 8 bits can't overflow
+					const Vector<Type, Bytes> wanted = splat<Vector<Type, Bytes>>(value);
+					
+					std::size_t totalCount = 0;
+					std::size_t index = 0;
+					
+					while (index + lanes <= count) {
+						
+						Mask<Type, Bytes> counters {};
+						for (std::size_t block = 0; block < blocksPerFlush && index + lanes <= count; ++block, index += lanes) {
+							counters -= (load<Vector<Type, Bytes>>(values + index) == wanted);
+						}
+						for (std::size_t lane = 0; lane < lanes; ++lane) {
+							totalCount += std::size_t(counters[lane]);
+						}
+					}
+					for (; index < count; ++index) {
+						totalCount += (values[index] == value);
+					}
+					return totalCount;
+				}
+			};
+			
+			template <template <std::size_t> class Kernel, typename... Arguments>
+			auto runVector(const Arguments&... arguments) -> decltype(Kernel<16>::run(arguments...)) {
+				return Kernel<16>::run(arguments...);
+			}
+			
+			#if defined(EVT_SIMD_X86)
+			template <template <std::size_t> class Kernel, typename... Arguments>
+			__attribute__((target("avx2"))) auto runAVX2(const Arguments&... arguments) -> decltype(Kernel<32>::run(arguments...)) {
+				return Kernel<32>::run(arguments...);
+			}
+			#endif
+			
+			/// Runs Kernel<vector bytes> with the selected instruction set
+			template <template <std::size_t> class Kernel, typename... Arguments>
+			auto run(const Arguments&... arguments) -> decltype(Kernel<16>::run(arguments...)) {
+				#if defined(EVT_SIMD_X86)
+					if (instructionSet() == InstructionSet::avx2) {
+						return runAVX2<Kernel>(arguments...);
+					}
+				#endif
+				return runVector<Kernel>(arguments...);
+			}
+			
+			#pragma GCC diagnostic pop
+			
+			template <typename Type, bool isMaximum = false>
+			struct Kernels {
+				template <std::size_t Bytes> using Sum = SumKernel<Type, Bytes>;
+				template <std::size_t Bytes> using KahanSum = KahanSumKernel<Type, Bytes>;
+				template <std::size_t Bytes> using Extreme = ExtremeKernel<Type, isMaximum, Bytes>;
+				template <std::size_t Bytes> using Find = FindKernel<Type, Bytes>;
+				template <std::size_t Bytes> using Count = CountKernel<Type, Bytes>;
+			};
+			
+			#endif
+			
+			template <typename Type>
+			inline bool usesKernels() noexcept {
+				return isVectorizable<Type>::value && instructionSet() != InstructionSet::scalar;
+			}
+			
+			// Scalar versions, also used for the types that can't be vectorized
+			
+			template <typename Type>
+			typename SumType<Type>::type scalarSum(const Type* values, const std::size_t count) {
+				typename SumType<Type>::type sum {};
+				for (std::size_t index = 0; index < count; ++index) {
+					sum = sum + values[index];
+				}
+				return sum;
+			}
+			
+			template <typename Type>
+			typename SumType<Type>::type scalarKahanSum(const Type* values, const std::size_t count, std::true_type) {
+				
+				typedef typename SumType<Type>::type Result;
+				
+				Result sum {}, compensation {};
+				for (std::size_t index = 0; index < count; ++index) {
+					const Result value = Result(values[index]) - compensation;
+					const Result newSum = sum + value;
+					compensation = (newSum - sum) - value;
+					sum = newSum;
+				}
+				return sum;
+			}
+			
+			template <typename Type>
+			typename SumType<Type>::type scalarKahanSum(const Type* values, const std::size_t count, std::false_type) {
+				return scalarSum(values, count);
+			}
+			
+			template <typename Type>
+			typename SumType<Type>::type scalarSum(const Type* values, const std::size_t count, const SummationMethod method) {
+				if (method == SummationMethod::kahan) {
+					return scalarKahanSum(values, count, std::integral_constant<bool, std::is_arithmetic<Type>::value>());
+				}
+				return scalarSum(values, count);
+			}
+			
+			template <typename Type>
+			typename SumType<Type>::type blockSum(const Type* values, const std::size_t count, const SummationMethod method, std::true_type) {
+				#if defined(EVT_SIMD_VECTORS)
+					if (usesKernels<Type>()) {
+						return (method == SummationMethod::kahan) ? run<Kernels<Type>::template KahanSum>(values, count) : run<Kernels<Type>::template Sum>(values, count);
+					}
+				#endif
+				return scalarSum(values, count, method);
+			}
+			
+			template <typename Type>
+			typename SumType<Type>::type blockSum(const Type* values, const std::size_t count, const SummationMethod method, std::false_type) {
+				return scalarSum(values, count, method);
+			}
+			
+			template <typename Type>
+			typename SumType<Type>::type pairwiseSum(const Type* values, const std::size_t count) {
+				
+				constexpr std::size_t blockSize = 256;
+				
+				if (count <= blockSize) {
+					return blockSum(values, count, SummationMethod::simple, std::integral_constant<bool, isVectorizable<Type>::value>());
+				}
+				
+				const std::size_t half = ((count / 2) + blockSize - 1) / blockSize * blockSize;
+				return pairwiseSum(values, half) + pairwiseSum(values + half, count - half);
+			}
+			
+			template <typename Type, bool isMaximum>
+			std::size_t extremeIndex(const Type* values, const std::size_t count, std::false_type) {
+				return std::size_t((isMaximum ? std::max_element(values, values + count) : std::min_element(values, values + count)) - values);
+			}
+			
+			template <typename Type>
+			std::size_t findIndex(const Type* values, const std::size_t count, const Type& value, std::false_type) {
+				return std::size_t(std::find(values, values + count, value) - values);
+			}
+			
+			template <typename Type>
+			std::size_t countEqual(const Type* values, const std::size_t count, const Type& value, std::false_type) {
+				return std::size_t(std::count(values, values + count, value));
+			}
+			
+			// Vectorized versions
+			
+			template <typename Type>
+			std::size_t findIndex(const Type* values, const std::size_t count, const Type& value, std::true_type) {
+				#if defined(EVT_SIMD_VECTORS)
+					if (usesKernels<Type>()) {
+						return run<Kernels<Type>::template Find>(values, count, value);
+					}
+				#endif
+				return findIndex(values, count, value, std::false_type());
+			}
+			
+			template <typename Type, bool isMaximum>
+			std::size_t extremeIndex(const Type* values, const std::size_t count, std::true_type) {
+				#if defined(EVT_SIMD_VECTORS)
+					if (usesKernels<Type>() && count > 0) {
+						const std::size_t index = findIndex(values, count, run<Kernels<Type, isMaximum>::template Extreme>(values, count), std::true_type());
+						// With a NaN the reduced value may not be any of the elements, then the scalar version picks one
+						if (index < count) { return index; }
+					}
+				#endif
+				return extremeIndex<Type, isMaximum>(values, count, std::false_type());
+			}
+			
+			template <typename Type>
+			std::size_t countEqual(const Type* values, const std::size_t count, const Type& value, std::true_type) {
+				#if defined(EVT_SIMD_VECTORS)
+					if (usesKernels<Type>()) {
+						return run<Kernels<Type>::template Count>(values, count, value);
+					}
+				#endif
+				return countEqual(values, count, value, std::false_type());
+			}
+		}
+		
+		template <typename Type>
+		using Vectorizable = std::integral_constant<bool, isVectorizable<Type>::value>;
+		
+		/// Sum of the values in SumType<Type>. Pairwise by default for floating point values
+		template <typename Type>
+		typename SumType<Type>::type sum(const Type* values, const std::size_t count,
+										 const SummationMethod method = std::is_floating_point<Type>::value ? SummationMethod::pairwise : SummationMethod::simple) {
+			if (method == SummationMethod::pairwise) {
+				return internalSimd::pairwiseSum(values, count);
+			}
+			return internalSimd::blockSum(values, count, method, Vectorizable<Type>());
+		}
+		
+		/// Index of the first smallest value, count if it's empty
+		template <typename Type>
+		std::size_t argmin(const Type* values, const std::size_t count) {
+			return internalSimd::extremeIndex<Type, false>(values, count, Vectorizable<Type>());
+		}
+		
+		/// Index of the first biggest value, count if it's empty
+		template <typename Type>
+		std::size_t argmax(const Type* values, const std::size_t count) {
+			return internalSimd::extremeIndex<Type, true>(values, count, Vectorizable<Type>());
+		}
+		
+		/// Index of the first value equal to value, count if there isn't any
+		template <typename Type>
+		std::size_t find(const Type* values, const std::size_t count, const Type& value) {
+			return internalSimd::findIndex(values, count, value, Vectorizable<Type>());
+		}
+		
+		template <typename Type>
+		std::size_t countOf(const Type* values, const std::size_t count, const Type& value) {
+			return internalSimd::countEqual(values, count, value, Vectorizable<Type>());
+		}
+	}
+}
+
+#undef EVT_SIMD_INLINE
@@ -0,0 +1,274 @@
+/*
+ The MIT License (MIT)
+ 
+ Copyright (c) 2017 Daniel Illescas Romero <https://github.com/illescasDaniel>
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+/*
+ Persistent thread pool used by the parallel algorithms of Array (parallelMap, parallelSort...).
+ Each worker has its own queue; it takes its newest tasks first and steals the oldest ones from
+ the other workers when its queue is empty. A thread waiting for a parallelFor runs pending tasks too,
+ so nested parallel calls don't block the pool.
+
+ Example:
+	
+	evt::ThreadPool fourThreads(4); // The calling thread + 3 workers
+	auto squares = numbers.parallelMap<double>([](const double& number) { return number * number; }, fourThreads);
+ */
+
+namespace evt {
+	
+	class ThreadPool {
+		
+		typedef std::function<void()> Task;
+		
+		struct WorkQueue {
+			std::mutex mutex;
+			std::deque<Task> tasks;
+		};
+		
+		struct WorkerIdentity {
+			const ThreadPool* pool;
+			std::size_t index;
+		};
+		
+		std::size_t threadCount_;
+		std::size_t queueCount;
+		std::unique_ptr<WorkQueue[]> queues;
+		std::unique_ptr<std::thread[]> workers;
+		
+		std::mutex sleepMutex;
+		std::condition_variable wakeUp;
+		std::atomic<std::size_t> queuedTasks {0};
+		std::atomic<std::size_t> nextQueue {0};
+		bool isStopping {false};
+		
+		static WorkerIdentity& currentWorker() noexcept {
+			static thread_local WorkerIdentity identity {nullptr, 0};
+			return identity;
+		}
+		
+		bool isWorkerThread() const noexcept {
+			return currentWorker().pool == this;
+		}
+		
+		void submit(Task&& task) {
+			
+			const std::size_t index = isWorkerThread() ? currentWorker().index : (nextQueue++ % queueCount);
+			
+			{
+				std::lock_guard<std::mutex> lock(sleepMutex);
+				queuedTasks += 1;
+			}
+			{
+				std::lock_guard<std::mutex> lock(queues[index].mutex);
+				queues[index].tasks.push_back(std::move(task));
+			}
+			
+			wakeUp.notify_one();
+		}
+		
+		/// Nobody waits for the tasks of execute, so an exception would end the program: it's reported and ignored instead
+		static void runTask(const Task& task) noexcept {
+			try {
+				task();
+			} catch (const std::exception& error) {
+				std::cerr << "Error: A ThreadPool task threw an exception: " << error.what() << std::endl;
+			} catch (...) {
+				std::cerr << "Error: A ThreadPool task threw an exception" << std::endl;
+			}
+		}
+		
+		/// Runs one pending task: the newest of the own queue, or the oldest of another one
+		bool tryRunTask() {
+			
+			const bool isWorker = isWorkerThread();
+			const std::size_t firstQueue = isWorker ? currentWorker().index : (nextQueue.load(std::memory_order_relaxed) % queueCount);
+			
+			Task task;
+			
+			for (std::size_t i = 0; i < queueCount && !task; ++i) {
+				
+				WorkQueue& queue = queues[(firstQueue + i) % queueCount];
+				std::lock_guard<std::mutex> lock(queue.mutex);
+				
+				if (queue.tasks.empty()) { continue; }
+				
+				if (isWorker && i == 0) {
+					task = std::move(queue.tasks.back());
+					queue.tasks.pop_back();
+				} else {
+					task = std::move(queue.tasks.front());
+					queue.tasks.pop_front();
+				}
+			}
+			
+			if (!task) { return false; }
+			
+			queuedTasks -= 1;
+			runTask(task);
+			
+			return true;
+		}
+		
+		void workerLoop(const std::size_t index) {
+			
+			currentWorker() = WorkerIdentity {this, index};
+			
+			while (true) {
+				
+				if (tryRunTask()) { continue; }
+				
+				std::unique_lock<std::mutex> lock(sleepMutex);
+				wakeUp.wait(lock, [this] { return isStopping || queuedTasks > 0; });
+				
+				if (isStopping && queuedTasks == 0) { return; }
+			}
+		}
+	
+	public:
+		
+		/// Uses threadCount threads in total: the one calling the parallel functions and threadCount-1 workers
+		explicit ThreadPool(const std::size_t threadCount = std::thread::hardware_concurrency()) {
+			
+			threadCount_ = (threadCount > 0) ? threadCount : 1;
+			queueCount = (threadCount_ > 1) ? (threadCount_ - 1) : 1;
+			queues = std::unique_ptr<WorkQueue[]>(new WorkQueue[queueCount]);
+			workers = std::unique_ptr<std::thread[]>(new std::thread[threadCount_ - 1]);
+			
+			for (std::size_t i = 0; i + 1 < threadCount_; ++i) {
+				workers[i] = std::thread([this, i] { workerLoop(i); });
+			}
+		}
+		
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		
+		/// Pool with a thread per core, created on first use
+		static ThreadPool& shared() {
+			static ThreadPool sharedPool;
+			return sharedPool;
+		}
+		
+		/// Runs the task on a worker without waiting for it (on the calling thread if the pool has no workers).
+		/// If the task throws, the exception is written to std::cerr and ignored
+		void execute(Task task) {
+			if (threadCount_ == 1) {
+				runTask(task);
+				return;
+			}
+			submit(std::move(task));
+		}
+		
+		std::size_t threadCount() const noexcept {
+			return threadCount_;
+		}
+		
+		/// Size of the chunks parallelFor uses: a few chunks per thread (so they can be stolen) of at least minimumChunkSize elements
+		std::size_t chunkSizeFor(const std::size_t count, const std::size_t minimumChunkSize) const noexcept {
+			
+			if (threadCount_ == 1) {
+				return (count > 0) ? count : 1;
+			}
+			
+			const std::size_t chunksPerThread = 4;
+			const std::size_t chunkSize = (count + threadCount_ * chunksPerThread - 1) / (threadCount_ * chunksPerThread);
+			
+			return std::max(chunkSize, std::max(minimumChunkSize, std::size_t(1)));
+		}
+		
+		/// Calls body(first, last) for consecutive chunks of [0, count) in parallel and waits for all of them.
+		/// After an exception the chunks that didn't start are skipped, and the first exception is rethrown.
+		template <typename Function>
+		void parallelFor(const std::size_t count, const std::size_t minimumChunkSize, const Function& body) {
+			
+			if (count == 0) { return; }
+			
+			const std::size_t chunkSize = chunkSizeFor(count, minimumChunkSize);
+			const std::size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+			
+			if (chunkCount == 1) {
+				body(std::size_t(0), count);
+				return;
+			}
+			
+			std::atomic<std::size_t> remainingChunks {chunkCount};
+			std::atomic<bool> hasFailed {false};
+			std::exception_ptr firstError;
+			std::mutex errorMutex;
+			
+			auto runChunk = [&](const std::size_t chunk) {
+				if (!hasFailed.load(std::memory_order_relaxed)) {
+					try {
+						body(chunk * chunkSize, std::min(count, (chunk + 1) * chunkSize));
+					} catch (...) {
+						std::lock_guard<std::mutex> lock(errorMutex);
+						if (!firstError) { firstError = std::current_exception(); }
+						hasFailed = true;
+					}
+				}
+				remainingChunks.fetch_sub(1, std::memory_order_acq_rel);
+			};
+			
+			for (std::size_t chunk = 1; chunk < chunkCount; ++chunk) {
+				submit([&runChunk, chunk] { runChunk(chunk); });
+			}
+			runChunk(0);
+			
+			while (remainingChunks.load(std::memory_order_acquire) > 0) {
+				if (!tryRunTask()) {
+					std::this_thread::yield();
+				}
+			}
+			
+			if (firstError) {
+				std::rethrow_exception(firstError);
+			}
+		}
+		
+		~ThreadPool() {
+			{
+				std::lock_guard<std::mutex> lock(sleepMutex);
+				isStopping = true;
+			}
+			wakeUp.notify_all();
+			
+			for (std::size_t i = 0; i + 1 < threadCount_; ++i) {
+				workers[i].join();
+			}
+		}
+	};
+}
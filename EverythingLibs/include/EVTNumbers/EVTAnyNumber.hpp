@@ -28,7 +28,7 @@
 	#include "EVTInt128.hpp"
 #endif
 
-#include <memory>
+#include "../EVTBasics/EVTPointer.hpp"
 
 namespace evt {
 	
@@ -41,17 +41,15 @@ namespace evt {
 #endif
 		class AnyNumber {
 			
-			std::shared_ptr<void*> value_ { nullptr };
+			SharedPointer<void> value_;
 			
 		public:
 			templateType
-			AnyNumber(const Type& value) {
-				this->value_ = std::make_shared<void*>(new Type{value});
-			}
+			AnyNumber(const Type& value): value_(SharedPointer<Type>::make(value)) {}
 			
 			templateType
 			Type& as() const {
-				return *static_cast<Type*>(*this->value_);
+				return *static_cast<Type*>(value_.get());
 			}
 			
 			templateType
@@ -61,8 +59,8 @@ namespace evt {
 			
 			templateType
 			Type& operator=(const Type& newValue) {
-				value_ = std::make_shared<void*>(new Type{newValue});
-				return *reinterpret_cast<Type*>(*value_);
+				value_ = SharedPointer<Type>::make(newValue);
+				return *static_cast<Type*>(value_.get());
 			}
 			
 			#define arithmeticOperation(name, operation) \
@@ -7,10 +7,15 @@
 //
 
 #include <iostream>
+#include "include/EVTBasics/EVTUnitTest.hpp"
 #include "include/EVT.hpp"
 #include "fullClassExample/Car.hpp"
 #include <thread>
 #include <vector>
+#include <cmath>
+#include <atomic>
+#include <cstdlib>
+#include <new>
 
 using namespace std;
 using namespace EVT;
@@ -73,6 +78,45 @@ public:
 	LazyThings(size_t iterations_ = 1): iterations(iterations_) {}
 };
 
+// Counts every heap allocation of the program: operator new always, malloc and calloc with glibc
+static atomic<size_t> heapAllocations {0};
+
+void* operator new(size_t size) {
+	heapAllocations++;
+	if (void* memory = std::malloc(size > 0 ? size : 1)) { return memory; }
+	throw bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+	std::free(memory);
+}
+
+#if defined(__GLIBC__)
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+
+extern "C" void* malloc(size_t size) {
+	heapAllocations++;
+	return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+	heapAllocations++;
+	return __libc_calloc(count, size);
+}
+#endif
+
+template <typename Function>
+size_t heapAllocationsOf(const Function& function) {
+	const size_t allocationsBefore = heapAllocations;
+	function();
+	return heapAllocations - allocationsBefore;
+}
+
 class Person: public Comparable<Person>, public Object {
 	
 	static void setAge(uint& age, const uint& newAge) {
@@ -109,6 +153,33 @@ public:
 
 int main(int argc, char* argv[]) {
 	
+	// Empty arrays and pointers don't allocate until they need memory (checked before any other thread starts)
+	{
+		UnitTest emptyContainers("Empty arrays and pointers don't allocate");
+		
+		emptyContainers.assert(heapAllocationsOf([]{ Array<int> numbers; }) == 0, "Array<int> allocated");
+		emptyContainers.assert(heapAllocationsOf([]{ Array<string> names; }) == 0, "Array<string> allocated");
+		emptyContainers.assert(heapAllocationsOf([]{ Pointer<int[]> numbers; }) == 0, "Pointer<int[]> allocated");
+		emptyContainers.assert(heapAllocationsOf([]{ RawPointer<int[]> numbers; }) == 0, "RawPointer<int[]> allocated");
+		emptyContainers.assert(heapAllocationsOf([]{ Pointer<int> number; }) == 0, "Pointer<int> allocated");
+		emptyContainers.assert(heapAllocationsOf([]{ RawPointer<int> number; }) == 0, "RawPointer<int> allocated");
+		
+		Array<int> clearedNumbers {1, 2, 3};
+		emptyContainers.assert(heapAllocationsOf([&]{ clearedNumbers.removeAll(); }) == 0, "Array<int>::removeAll allocated");
+		
+		emptyContainers.assert(heapAllocationsOf([]{ Pointer<int[]> numbers(8); }) > 0, "The allocations aren't being counted");
+		emptyContainers.assert(heapAllocationsOf([]{ Array<int> numbers {1, 2, 3}; }) > 0, "The allocations aren't being counted");
+	}
+	
+	// The vectorized min and max still give one of the elements when there is a NaN
+	{
+		UnitTest minimumWithNaN("argmin and argmax with a NaN");
+		const Array<float> numbersWithNaN {1.f, numeric_limits<float>::quiet_NaN(), 2.f, 3.f, 4.f, 5.f, 6.f, 7.f, 8.f};
+		
+		minimumWithNaN.assert(numbersWithNaN.argmin() < numbersWithNaN.count(), "argmin is out of the array");
+		minimumWithNaN.assert(numbersWithNaN.argmax() < numbersWithNaN.count(), "argmax is out of the array");
+	}
+	
 	print(typeOf(10));
 	
 	Array<string> names0_ { "daniel", "test", "lol" };
@@ -439,6 +510,408 @@ int main(int argc, char* argv[]) {
 		
 	}) << endl;
 	
+	cout << benchmark([]{
+		
+		vector<size_t> numbers;
+		
+		for (size_t i = 0; i < 1000000; i++) {
+			numbers.push_back(i);
+		}
+		
+	}) << endl;
+	
+	// Per request churn: 20K requests building two arrays of 50 ints each, with the heap, an arena released
+	// after every request and a pool that reuses the freed memory (released after all the requests)
+	auto handleRequests = [](const auto& makeAllocator, const auto& endRequest) {
+		volatile int requestChecksum = 0;
+		for (size_t request = 0; request < 20000; request++) {
+			{
+				const auto allocator = makeAllocator();
+				Array<int, typename decay<decltype(allocator)>::type> ids(allocator);
+				Array<int, typename decay<decltype(allocator)>::type> scores(allocator);
+				for (int i = 0; i < 50; i++) {
+					ids.append(i);
+					scores.append(i * 2);
+				}
+				requestChecksum = ids[49] + scores[49];
+			}
+			endRequest();
+		}
+	};
+	
+	MonotonicArena requestArena;
+	SizeClassPool requestPool;
+	
+	const float heapRequestsTime = benchmark([&]{
+		handleRequests([]{ return DefaultAllocator(); }, []{});
+	}, 5);
+	
+	const float arenaRequestsTime = benchmark([&]{
+		handleRequests([&]{ return ArenaAllocator<MonotonicArena>(requestArena); }, [&]{ requestArena.release(); });
+	}, 5);
+	
+	const float poolRequestsTime = benchmark([&]{
+		handleRequests([&]{ return ArenaAllocator<SizeClassPool>(requestPool); }, []{});
+		requestPool.release();
+	}, 5);
+	
+	cout << "20K requests. heap: " << heapRequestsTime << "s, arena: " << arenaRequestsTime << "s, pool: " << poolRequestsTime << "s" << endl;
+	
+	// Growing an array of arrays only moves their pointers (100K rows of 256 ints)
+	Array<int> row;
+	for (int i = 0; i < 256; i++) {
+		row.append(i);
+	}
+	
+	const float arrayOfArraysTime = benchmark([&]{
+		Array<Array<int>> rows;
+		for (size_t i = 0; i < 100000; i++) {
+			rows.append(row);
+		}
+	}, 5);
+	
+	const float vectorOfArraysTime = benchmark([&]{
+		vector<Array<int>> rows;
+		for (size_t i = 0; i < 100000; i++) {
+			rows.push_back(row);
+		}
+	}, 5);
+	
+	cout << "Array<Array<int>> growth: " << arrayOfArraysTime << "s, vector<Array<int>> growth: " << vectorOfArraysTime << "s" << endl;
+	
+	// Copying and destroying shared pointers (10M copies in one thread, 2.5M in each of 4 threads)
+	volatile size_t pointerChecksum = 0;
+	auto copyPointer = [&](const auto& pointer, const size_t copies) {
+		for (size_t i = 0; i < copies; i++) {
+			auto copy = pointer;
+			pointerChecksum = *copy;
+		}
+	};
+	auto copyPointerFrom4Threads = [&](const auto& pointer) {
+		return benchmark([&]{
+			vector<thread> threads;
+			for (int i = 0; i < 4; i++) {
+				threads.emplace_back([&]{ copyPointer(pointer, 2500000); });
+			}
+			for (auto& thread: threads) {
+				thread.join();
+			}
+		});
+	};
+	
+	const auto stdSharedNumber = make_shared<int>(1);
+	const auto sharedNumber = SharedPointer<int>::make(1);
+	const auto threadSharedNumber = SharedPointer<int, NonAtomicReferenceCount>::make(1);
+	
+	cout << "1 thread. std::shared_ptr: " << benchmark([&]{ copyPointer(stdSharedNumber, 10000000); })
+		 << "s, SharedPointer: " << benchmark([&]{ copyPointer(sharedNumber, 10000000); })
+		 << "s, SharedPointer (non atomic): " << benchmark([&]{ copyPointer(threadSharedNumber, 10000000); }) << "s" << endl;
+	cout << "4 threads. std::shared_ptr: " << copyPointerFrom4Threads(stdSharedNumber)
+		 << "s, SharedPointer: " << copyPointerFrom4Threads(sharedNumber) << "s" << endl;
+	
+	// Optionals keep their value inline, Array::at doesn't allocate (1M short strings)
+	Array<string> numberNames;
+	for (size_t i = 0; i < 1000000; i++) {
+		numberNames.append(to_string(i));
+	}
+	
+	size_t namesLength = 0;
+	cout << "1M Array::at: " << benchmark([&]{
+		for (size_t i = 0; i < numberNames.count(); i++) {
+			namesLength += numberNames.at(i).map([](const string& name) { return name.size(); }).valueOr(0);
+		}
+	}) << "s" << endl;
+	
+	// Records of Any values: ints, doubles and short strings are stored inside each Any (~1M values)
+	double recordsTotal = 0;
+	cout << "1M Any built and read: " << benchmark([&]{
+		Array<Any> record;
+		for (int i = 0; i < 999999; i += 3) {
+			record.append(Any(i));
+			record.append(Any(i * 0.5));
+			record.append(Any("key"));
+		}
+		for (size_t i = 0; i < record.count(); i += 3) {
+			recordsTotal += record[i].as<int>() + record[i + 1].as<double>();
+		}
+	}) << "s" << endl;
+	
+	// std::function vs template callables (1M ints)
+	Array<int> unsortedNumbers;
+	for (size_t i = 0; i < 1000000; i++) {
+		unsortedNumbers.append(int((i * 2654435761u) % 1000003));
+	}
+	
+	function<bool(int&, int&)> lessFunction = [](int& a, int& b) { return a < b; };
+	function<int(const int&)> tripleFunction = [](const int& number) { return number * 3 + 1; };
+	
+	cout << "sort. std::function: " << benchmark([&]{
+		Array<int> numbers(unsortedNumbers);
+		numbers.sort(lessFunction);
+	}, 5) << ", template: " << benchmark([&]{
+		Array<int> numbers(unsortedNumbers);
+		numbers.sort([](const int& a, const int& b) { return a < b; });
+	}, 5) << endl;
+	
+	cout << "map. std::function: " << benchmark([&]{
+		unsortedNumbers.map(tripleFunction);
+	}, 5) << ", template: " << benchmark([&]{
+		unsortedNumbers.map([](const int& number) { return number * 3 + 1; });
+	}, 5) << endl;
+	
+	// Parallel algorithms scaling
+	Array<double> parallelNumbers;
+	for (size_t i = 0; i < 10000000; i++) {
+		parallelNumbers.append(double((i * 2654435761u) % 1000000));
+	}
+	
+	for (size_t threadCount: {size_t(1), size_t(2), size_t(4), size_t(8), size_t(thread::hardware_concurrency())}) {
+		
+		ThreadPool pool(threadCount);
+		
+		cout << threadCount << " threads. map: " << benchmark([&]{
+			parallelNumbers.parallelMap([](const double& number) { return sqrt(number) * log1p(number); }, pool);
+		}) << ", reduce: " << benchmark([&]{
+			parallelNumbers.parallelReduce([](const double result, const double& number) { return result + number; }, 0.0, pool);
+		}) << ", sort: " << benchmark([&]{
+			parallelNumbers.parallelSorted(less<double>(), pool);
+		}) << endl;
+	}
+	
+	// Growth policies. Bursts of 1000 pushes and pops over 100 elements
+	auto oscillation = [](auto emptyNumbers) {
+		return benchmark([&]{
+			
+			auto numbers = emptyNumbers;
+			
+			for (size_t i = 0; i < 2000; i++) {
+				numbers.append(i);
+			}
+			while (numbers.count() > 100) {
+				numbers.removeLast();
+			}
+			
+			for (size_t cycle = 0; cycle < 2000; cycle++) {
+				for (size_t i = 0; i < 1000; i++) { numbers.append(i); }
+				for (size_t i = 0; i < 1000; i++) { numbers.removeLast(); }
+			}
+		}, 5);
+	};
+	
+	cout << "oscillation. doubling: " << oscillation(Array<size_t, DefaultAllocator, 0, DoublingGrowth>())
+		 << ", 1.5x: " << oscillation(Array<size_t, DefaultAllocator, 0, OneAndHalfGrowth>())
+		 << ", size classes: " << oscillation(Array<size_t, DefaultAllocator, 0, SizeClassGrowth>())
+		 << ", pages: " << oscillation(Array<size_t, DefaultAllocator, 0, PageRoundedGrowth>())
+		 << ", never shrink: " << oscillation(Array<size_t, DefaultAllocator, 0, NeverShrinkGrowth>()) << endl;
+	
+	// Reading a 1GB file (counting its lines): File::toString vs File::map
+	const string bigFileName = "evtBigFile.txt";
+	{
+		ofstream bigFileStream(bigFileName, ios::binary);
+		const string line(99, 'x');
+		for (size_t i = 0; i < 1024 * 1024 * 1024 / 100; i++) {
+			bigFileStream << line << '\n';
+		}
+	}
+	
+	cout << "1GB file. toString: " << benchmark([&]{
+		const string content = File::toString(bigFileName);
+		std::count(content.begin(), content.end(), '\n');
+	}) << ", map: " << benchmark([&]{
+		const MappedFile content = File(bigFileName).map(AccessPattern::sequential);
+		std::count(content.begin(), content.end(), '\n');
+	}) << endl;
+	
+	std::remove(bigFileName.c_str());
+
+#if (cplusplusVersion >= cplusplus1z) && __has_include(<string_view>)
+	
+	// Scanning the lines of a log: File::safeGetline vs File::lines
+	const string logFileName = "evtLog.txt";
+	const size_t logLineCount = 10000000;
+	{
+		ofstream logFileStream(logFileName, ios::binary);
+		for (size_t i = 0; i < logLineCount; i++) {
+			logFileStream << "2017-07-07 12:00:00 INFO request " << i << " done\n";
+		}
+	}
+	const double logMegabytes = double(ifstream(logFileName, ios::ate | ios::binary).tellg()) / (1024 * 1024);
+	
+	const float getlineTime = benchmark([&]{
+		File logFile(logFileName);
+		while (const auto line = logFile.safeGetline()) {}
+	});
+	const float linesTime = benchmark([&]{
+		for (const StringView line: File(logFileName).lines()) { (void)line; }
+	});
+	
+	cout << "log lines. safeGetline: " << logLineCount / getlineTime << " lines/s, " << logMegabytes / getlineTime << " MB/s"
+		 << ", lines: " << logLineCount / linesTime << " lines/s, " << logMegabytes / linesTime << " MB/s" << endl;
+	
+	// Counting the lines with "INFO" of the log: getline loop vs File::parallelScan
+	const float getlineCountTime = benchmark([&]{
+		ifstream logFileStream(logFileName);
+		string line;
+		size_t infoLines = 0;
+		while (getline(logFileStream, line)) {
+			infoLines += (line.find("INFO") != string::npos);
+		}
+	});
+	const float parallelScanTime = benchmark([&]{
+		File(logFileName).parallelScan(size_t(0), [](size_t& infoLines, const StringView line) {
+			infoLines += line.contains("INFO");
+		});
+	});
+	
+	cout << "log INFO lines. getline: " << logMegabytes / getlineCountTime << " MB/s, parallelScan: " << logMegabytes / parallelScanTime << " MB/s" << endl;
+	
+	// The log written and read compressed (the codecs compiled with EVT_USE_ZLIB, EVT_USE_ZSTD and EVT_USE_LZ4)
+	for (const auto& codec: {make_pair(Compression::none, ".txt"), make_pair(Compression::gzip, ".gz"), make_pair(Compression::zstd, ".zst"), make_pair(Compression::lz4, ".lz4")}) {
+		
+		if (!isAvailable(codec.first)) { continue; }
+		
+		const string compressedLogName = "evtCompressedLog" + string(codec.second);
+		
+		const float compressTime = benchmark([&]{
+			FileWriter compressedLog = File(compressedLogName).writer(1024 * 1024, Durability::none, false);
+			for (const StringView line: File(logFileName).lines()) {
+				compressedLog.write(line.data(), line.size());
+				compressedLog.write('\n');
+			}
+		});
+		const float decompressTime = benchmark([&]{
+			for (const StringView line: File(compressedLogName).lines()) { (void)line; }
+		});
+		const double compressedMegabytes = double(ifstream(compressedLogName, ios::ate | ios::binary).tellg()) / (1024 * 1024);
+		std::remove(compressedLogName.c_str());
+		
+		cout << "log " << codec.second << ": " << compressedMegabytes << " MB, written at " << logMegabytes / compressTime
+			 << " MB/s, lines at " << logMegabytes / decompressTime << " MB/s" << endl;
+	}
+	
+	std::remove(logFileName.c_str());
+#endif
+	
+	// Writing 100M small records: File::writeInBinary vs File::writer
+	const string recordsFileName = "evtRecords.bin";
+	const size_t recordCount = 100000000;
+	const double recordsMegabytes = double(recordCount * sizeof(size_t)) / (1024 * 1024);
+	
+	const float writeInBinaryTime = benchmark([&]{
+		File recordsFile(recordsFileName);
+		for (size_t i = 0; i < recordCount; i++) {
+			recordsFile.writeInBinary(i);
+		}
+	});
+	std::remove(recordsFileName.c_str());
+	
+	const float writerTime = benchmark([&]{
+		FileWriter recordsWriter = File(recordsFileName).writer();
+		for (size_t i = 0; i < recordCount; i++) {
+			recordsWriter.writeInBinary(i);
+		}
+	});
+	
+	cout << "100M records. writeInBinary: " << recordsMegabytes / writeInBinaryTime << " MB/s, writer: " << recordsMegabytes / writerTime << " MB/s" << endl;
+	
+	// Reading them back as 64 byte records: a new string per record vs reusing the same one
+	const float newStringTime = benchmark([&]{
+		File recordsFile(recordsFileName, File::binary);
+		while (!recordsFile.readFromBinary<string>(64).empty()) {}
+	});
+	
+	const float reusedStringTime = benchmark([&]{
+		File recordsFile(recordsFileName, File::binary);
+		string record;
+		while (recordsFile.readFromBinary(record, 64) > 0) {}
+	});
+	std::remove(recordsFileName.c_str());
+	
+	cout << "64 byte records. readFromBinary<string>: " << recordsMegabytes / newStringTime << " MB/s, reusing the string: " << recordsMegabytes / reusedStringTime << " MB/s" << endl;
+	
+	// Alternating writes and reads on the same File, the stream is opened only once
+	File alternatingFile(recordsFileName, File::binary);
+	const float alternatingTime = benchmark([&]{
+		for (size_t i = 0; i < 100000; i++) {
+			alternatingFile.writeInBinary(i);
+			alternatingFile.readFromBinary<size_t>();
+		}
+	});
+	std::remove(recordsFileName.c_str());
+	
+	cout << "100K alternating writeInBinary + readFromBinary: " << 100000 / alternatingTime << " pairs/s, opens: " << alternatingFile.openCount() << endl;
+	
+	// Random 4KiB reads (from a 1GB file) keeping 1 to 64 of them in flight
+	const string randomFileName = "evtRandomReads.bin";
+	const size_t blockCount = 1024 * 1024 * 1024 / 4096;
+	{
+		FileWriter randomFileWriter = File(randomFileName).writer();
+		const string block(4096, 'x');
+		for (size_t i = 0; i < blockCount; i++) {
+			randomFileWriter.write(block);
+		}
+	}
+	
+	AsyncFile randomFile = File(randomFileName).async();
+	const size_t readCount = 100000;
+	
+	for (size_t queueDepth: {size_t(1), size_t(2), size_t(4), size_t(8), size_t(16), size_t(32), size_t(64)}) {
+		
+		Array<char> buffers(queueDepth * 4096, char());
+		Array<future<size_t>> readsInFlight(queueDepth);
+		for (size_t i = 0; i < queueDepth; i++) {
+			readsInFlight.append(future<size_t>());
+		}
+		
+		const float readsTime = benchmark([&]{
+			for (size_t i = 0; i < readCount; i++) {
+				future<size_t>& slot = readsInFlight[i % queueDepth];
+				if (slot.valid()) { slot.get(); }
+				slot = randomFile.readAsync(&buffers[(i % queueDepth) * 4096], 4096, ((i * 2654435761u) % blockCount) * 4096);
+			}
+			for (future<size_t>& slot: readsInFlight) {
+				if (slot.valid()) { slot.get(); }
+			}
+		});
+		
+		cout << "queue depth " << queueDepth << ": " << readCount / readsTime << " reads/s" << endl;
+	}
+	
+	// The same random reads from 4 threads sharing one file: a stream with a lock (seek + read) or File::readAt
+	const auto readsFrom4Threads = [&](const function<void(size_t offset, char* buffer)>& readBlock) {
+		return benchmark([&]{
+			thread readers[4];
+			for (size_t t = 0; t < 4; t++) {
+				readers[t] = thread([&, t]{
+					char buffer[4096];
+					for (size_t i = t; i < readCount; i += 4) {
+						readBlock(((i * 2654435761u) % blockCount) * 4096, buffer);
+					}
+				});
+			}
+			for (thread& reader: readers) {
+				reader.join();
+			}
+		});
+	};
+	
+	ifstream sharedStream(randomFileName, ios::binary);
+	mutex sharedStreamMutex;
+	const float seekTime = readsFrom4Threads([&](size_t offset, char* buffer) {
+		lock_guard<mutex> lock(sharedStreamMutex);
+		sharedStream.seekg(offset);
+		sharedStream.read(buffer, 4096);
+	});
+	
+	const File sharedFile(randomFileName, File::binary);
+	const float readAtTime = readsFrom4Threads([&](size_t offset, char* buffer) {
+		sharedFile.readAt(offset, buffer, 4096);
+	});
+	
+	cout << "4 threads. seek + read: " << readCount / seekTime << " reads/s, readAt: " << readCount / readAtTime << " reads/s" << endl;
+	
+	std::remove(randomFileName.c_str());
+	
 	Pointer<int> number(900);
 	cout << *number << endl;
 	